@@ -23,16 +23,53 @@
 
 */
 
+#include <limits.h>
 #include "config.h"
+#if FEATURE_CLI
+#include "cli.h"
+#endif
+#include "event.h"
 #include "led.h"
 #include "aoxa.h"
 #include "wifi.h"
+#if FEATURE_NTP
 #include "ntp.h"
+#endif
+#if FEATURE_HTTP
 #include "http.h"
+#endif
+#if FEATURE_MQTT
 #include "mqtt.h"
+#endif
+#if FEATURE_OTA
+#include "ota.h"
+#endif
+#if FEATURE_RULES
+#include "rules.h"
+#endif
+#if FEATURE_SCHEDULE
+#include "schedule.h"
+#endif
 #include "state.h"
 #include "util.h"
 
+/*
+   get the time in seconds since the device was configured last, via HTTP
+   or the serial console -- one of them is always there
+*/
+static int loop_config_idle(void)
+{
+  int idle = INT_MAX;
+
+#if FEATURE_HTTP
+  idle = min(idle, HttpLastRequest());
+#endif
+#if FEATURE_CLI
+  idle = min(idle, CliLastCommand());
+#endif
+  return idle;
+}
+
 void setup()
 {
   /*
@@ -41,32 +78,53 @@ void setup()
   Serial.begin(115200);
   Serial.println();
   LogMsg("*** " __TITLE__ " - Version " GIT_VERSION " ***");
+  BootPhase("serial");
 
   /*
      initialize the basic sub-systems
   */
   LedSetup(LED_MODE_ON);
+  EventSetup();
   StateSetup(STATE_OPERATION);
 
   if (!ConfigSetup())
     StateChange(STATE_CONFIGURING);
+  BootPhase("config");
 
-  if (!WifiSetup()) {
-    /*
-       something wen't wrong -- enter configuration mode
-    */
-    LogMsg("SETUP: no WIFI connection -- entering configuration mode");
-    StateSetup(STATE_CONFIGURING);
-    WifiSetup();
-  }
+  /*
+     bring up the light output first -- rules and schedule are
+     set up before, as they react on the initial mode
+  */
+#if FEATURE_RULES
+  RulesSetup();
+#endif
+#if FEATURE_SCHEDULE
+  ScheduleSetup();
+#endif
+  AoxaSetup();
+  BootPhase("aoxa");
 
   /*
-     setup the other sub-systems
+     setup the network sub-systems -- the WiFi connects in the background,
+     NTP and MQTT will follow as soon as it is up
   */
+  WifiSetup();
+#if FEATURE_NTP
   NtpSetup();
+#endif
+#if FEATURE_HTTP
   HttpSetup();
+#endif
+#if FEATURE_OTA
+  OtaSetup();
+#endif
+#if FEATURE_MQTT
   MqttSetup();
-  AoxaSetup();
+#endif
+#if FEATURE_CLI
+  CliSetup();
+#endif
+  BootPhase("setup");
 }
 
 void loop()
@@ -74,13 +132,29 @@ void loop()
   /*
      do the cyclic updates of the sub systems
   */
+  EventUpdate();
   ConfigUpdate();
   LedUpdate();
   WifiUpdate();
+#if FEATURE_NTP
   NtpUpdate();
+#endif
+#if FEATURE_HTTP
   HttpUpdate();
+#endif
+#if FEATURE_OTA
+  OtaUpdate();
+#endif
+#if FEATURE_MQTT
   MqttUpdate();
+#endif
   AoxaUpdate();
+#if FEATURE_SCHEDULE
+  ScheduleUpdate();
+#endif
+#if FEATURE_CLI
+  CliUpdate();
+#endif
 
   /*
      what to do?
@@ -92,12 +166,13 @@ void loop()
       */
       LedSetup(LED_MODE_BLINK_FAST);
       /*
-         if there is no activity via HTTP, we will reboot
+         if there is no activity via HTTP or the serial console, we
+         will reboot
 
          this is in case where the device has switched by its own
          into the configuration mode.
       */
-      if (HttpLastRequest() > STATE_CONFIGURING_TIMEOUT) {
+      if (loop_config_idle() > STATE_CONFIGURING_TIMEOUT) {
         LogMsg("LOOP: restarting hte device");
         StateChange(STATE_REBOOT);
       }
@@ -108,7 +183,8 @@ void loop()
       */
       LogMsg("LOOP: restarting the device");
       LedSetup(LED_MODE_OFF);
-      AoxaChangeMode(AOXA_MODE_OFF);
+      AoxaShutdown();
+      ConfigFlush();
       ESP.restart();
       break;
   }
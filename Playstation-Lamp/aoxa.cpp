@@ -24,55 +24,260 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <analogWrite.h>
+#include <esp_system.h>
 #include "aoxa.h"
 #include "config.h"
-#include "mqtt.h"
+#include "event.h"
 #include "util.h"
 
+/*
+   the effects are specialized for this number of LEDs at compile time,
+   any other number is handled by the generic version
+*/
+#define AOXA_LEDS_FAST    4
+
 // ESP32
-static int _aoxa_led_pin[AOXA_LEDS] = {
-  GPIO_NUM_16,
-  GPIO_NUM_17,
-  GPIO_NUM_21,
-  GPIO_NUM_22
-};
+static int _aoxa_leds = 0;
+static int _aoxa_led_pin[AOXA_LEDS_MAX];
+static int _aoxa_led_value[AOXA_LEDS_MAX];   // the last value written, for mirrors of the lamp
 static int _aoxa_button_pin = GPIO_NUM_27;
 
 static int _aoxa_mode = AOXA_MODE_OFF;
+static int _aoxa_brightness = AOXA_BRIGHTNESS_MAX;
 static unsigned long _aoxa_next = 0;
 
 /*
-    setup the configuration
+   the cached config and its generation
 */
-void AoxaSetup(void)
+static CONFIG_AOXA _config_aoxa;
+static uint32_t _aoxa_config_generation = ~0;
+
+/*
+   the speeds of the recalled preset -- zero keeps the configured speed
+*/
+static CONFIG_AOXA _aoxa_override;
+
+#define AOXA_SPEED(name)  (_aoxa_override.name ? _aoxa_override.name : _config_aoxa.name)
+
+/*
+   the phase of the effects
+*/
+typedef struct {
+  int16_t fade_pos;
+  bool fade_forward;
+  bool flash_toggle;
+  uint16_t blink_state;   // one bit per LED, see AOXA_LEDS_MAX
+} AOXA_PHASE;
+
+static AOXA_PHASE _aoxa_phase = { 0, true, false, 0 };
+
+/*
+   the runtime state is kept in the RTC memory, which survives soft resets
+   like ESP.restart(), watchdog resets or panics -- so we can resume the
+   output immediately without writing to the flash
+*/
+#define AOXA_RTC_MAGIC    0x414f5841    // AOXA
+
+typedef struct {
+  uint32_t magic;
+  int8_t mode;
+  uint8_t brightness;
+  AOXA_PHASE phase;
+  uint32_t crc;
+} AOXA_RTC;
+
+static RTC_NOINIT_ATTR AOXA_RTC _aoxa_rtc;
+
+/*
+   save the runtime state into the RTC memory
+*/
+static void aoxa_rtc_save(void)
 {
-  LogMsg("AOXA: checking & correting config");
+  _aoxa_rtc.magic = AOXA_RTC_MAGIC;
+  _aoxa_rtc.mode = _aoxa_mode;
+  _aoxa_rtc.brightness = _aoxa_brightness;
+  _aoxa_rtc.phase = _aoxa_phase;
+  _aoxa_rtc.crc = Crc32(&_aoxa_rtc, offsetof(AOXA_RTC, crc));
+}
+
+/*
+   check if the RTC memory holds a valid runtime state
+
+   after a power on, the RTC memory holds garbage
+*/
+static bool aoxa_rtc_valid(void)
+{
+  esp_reset_reason_t reason = esp_reset_reason();
+
+  if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT)
+    return false;
+  if (_aoxa_rtc.magic != AOXA_RTC_MAGIC || _aoxa_rtc.crc != Crc32(&_aoxa_rtc, offsetof(AOXA_RTC, crc)))
+    return false;
+  if (_aoxa_rtc.mode < AOXA_MODE_OFF || _aoxa_rtc.mode > AOXA_MODE_LAST || _aoxa_rtc.brightness > AOXA_BRIGHTNESS_MAX)
+    return false;
+  return true;
+}
+
+/*
+   set a LED with respect to the brightness
+*/
+static void aoxa_write(int led, int value)
+{
+  analogWrite(_aoxa_led_pin[led], _aoxa_led_value[led] = value * _aoxa_brightness / AOXA_BRIGHTNESS_MAX);
+}
+
+/*
+   set all LEDs with respect to the brightness
+*/
+static void aoxa_write_all(int value)
+{
+  for (int led = 0; led < _aoxa_leds; led++)
+    aoxa_write(led, value);
+}
+
+/*
+   compute the next frame of the current effect
+
+   with LEDS given, the number of LEDs is a constant, so the compiler can
+   unroll the loops -- otherwise the given number of LEDs is used
+
+   returns the time until the next frame [ms]
+*/
+template <int LEDS>
+static unsigned long aoxa_frame(int leds)
+{
+  if (LEDS)
+    leds = LEDS;
+
+  switch (_aoxa_mode) {
+    case AOXA_MODE_FADE:
+      /*
+         fade: back and forth fading
+
+         pos is an virtual spot which moves forth and back (with a higher resolution than the number of LEDs),
+         the leds will be set with an an intensity which depends on the distance to that spot
+      */
+      {
+        const int range = AOXA_FADE_RANGE(leds);
+
+        if (_aoxa_phase.fade_forward) {
+          if (++_aoxa_phase.fade_pos >= range) {
+            _aoxa_phase.fade_pos--;
+            _aoxa_phase.fade_forward = !_aoxa_phase.fade_forward;
+          }
+        }
+        else {
+          if (--_aoxa_phase.fade_pos < 0) {
+            _aoxa_phase.fade_pos++;
+            _aoxa_phase.fade_forward = !_aoxa_phase.fade_forward;
+          }
+        }
+
+        /*
+           the spot of LED n is at n * range / (leds - 1), the distances
+           are scaled by (leds - 1) to stay with integers
+        */
+        if (leds == 1)
+          aoxa_write(0, _aoxa_phase.fade_pos * ANALOG_HIGH / range);
+        else
+          for (int led = 0; led < leds; led++)
+            aoxa_write(led, abs(_aoxa_phase.fade_pos * (leds - 1) - led * range) * ANALOG_HIGH / (range * (leds - 1)));
+        return AOXA_SPEED(fade_speed);
+      }
+    case AOXA_MODE_FLASH:
+      /*
+         flash: all LEDs will toggle
+      */
+      _aoxa_phase.flash_toggle = !_aoxa_phase.flash_toggle;
+      for (int led = 0; led < leds; led++)
+        aoxa_write(led, (_aoxa_phase.flash_toggle) ? ANALOG_HIGH : ANALOG_LOW);
+      return AOXA_SPEED(flash_speed);
+    case AOXA_MODE_BLINK:
+      /*
+         blink: in each cycle one random LED will be toggled
+      */
+      {
+        int led = random(leds);
+
+        _aoxa_phase.blink_state ^= 1 << led;
+        aoxa_write(led, (_aoxa_phase.blink_state & (1 << led)) ? ANALOG_LOW : ANALOG_HIGH);
+        return AOXA_SPEED(blink_speed);
+      }
+    case AOXA_MODE_FIRE:
+      /*
+         fire: all LEDs will get a different intensity
+      */
+      for (int led = 0; led < leds; led++)
+        aoxa_write(led, AOXA_FIRE_LOW + random(AOXA_FIRE_HIGH - AOXA_FIRE_LOW));
+      return AOXA_SPEED(fire_speed);
+  }
+  return 0;
+}
+
+/*
+   refresh the cached config if it has changed
+
+   this is done for each frame, so it has to be cheap if nothing changed
+*/
+static void aoxa_config_update(void)
+{
+  if (ConfigGeneration() == _aoxa_config_generation)
+    return;
+
+  _aoxa_config_generation = CONFIG_GET(AOXA, aoxa, &_config_aoxa);
 
   /*
      check and correct the config
   */
-  if (_config.aoxa.default_mode < AOXA_MODE_OFF || _config.aoxa.default_mode >= AOXA_MODE_LAST)
-    _config.aoxa.default_mode = AOXA_MODE_OFF;
-  if (!_config.aoxa.fade_speed)
-    _config.aoxa.fade_speed = AOXA_FADE_SPEED_DEFAULT;
-  _config.aoxa.fade_speed = min(max(_config.aoxa.fade_speed, AOXA_FADE_SPEED_MIN), AOXA_FADE_SPEED_MAX);
-  if (!_config.aoxa.flash_speed)
-    _config.aoxa.flash_speed = AOXA_FLASH_SPEED_DEFAULT;
-  _config.aoxa.flash_speed = min(max(_config.aoxa.flash_speed, AOXA_FLASH_SPEED_MIN), AOXA_FLASH_SPEED_MAX);
-  if (!_config.aoxa.blink_speed)
-    _config.aoxa.blink_speed = AOXA_BLINK_SPEED_DEFAULT;
-  _config.aoxa.blink_speed = min(max(_config.aoxa.blink_speed, AOXA_BLINK_SPEED_MIN), AOXA_BLINK_SPEED_MAX);
-  if (!_config.aoxa.fire_speed)
-    _config.aoxa.fire_speed = AOXA_FIRE_SPEED_DEFAULT;
-  _config.aoxa.fire_speed = min(max(_config.aoxa.fire_speed, AOXA_FIRE_SPEED_MIN), AOXA_FIRE_SPEED_MAX);
+  if (_config_aoxa.default_mode < AOXA_MODE_OFF || _config_aoxa.default_mode >= AOXA_MODE_LAST)
+    _config_aoxa.default_mode = AOXA_MODE_OFF;
+  if (!_config_aoxa.fade_speed)
+    _config_aoxa.fade_speed = AOXA_FADE_SPEED_DEFAULT;
+  _config_aoxa.fade_speed = min(max(_config_aoxa.fade_speed, AOXA_FADE_SPEED_MIN), AOXA_FADE_SPEED_MAX);
+  if (!_config_aoxa.flash_speed)
+    _config_aoxa.flash_speed = AOXA_FLASH_SPEED_DEFAULT;
+  _config_aoxa.flash_speed = min(max(_config_aoxa.flash_speed, AOXA_FLASH_SPEED_MIN), AOXA_FLASH_SPEED_MAX);
+  if (!_config_aoxa.blink_speed)
+    _config_aoxa.blink_speed = AOXA_BLINK_SPEED_DEFAULT;
+  _config_aoxa.blink_speed = min(max(_config_aoxa.blink_speed, AOXA_BLINK_SPEED_MIN), AOXA_BLINK_SPEED_MAX);
+  if (!_config_aoxa.fire_speed)
+    _config_aoxa.fire_speed = AOXA_FIRE_SPEED_DEFAULT;
+  _config_aoxa.fire_speed = min(max(_config_aoxa.fire_speed, AOXA_FIRE_SPEED_MIN), AOXA_FIRE_SPEED_MAX);
+  if (!_config_aoxa.pins[0])
+    strcpy(_config_aoxa.pins, AOXA_PINS_DEFAULT);
+}
+
+/*
+   take over the pins from the config
+
+   the LEDC channels are bound to the pins with the first write, so a
+   changed pin map takes effect with the next restart only
+*/
+static void aoxa_pins_setup(void)
+{
+  if ((_aoxa_leds = AoxaParsePins(_config_aoxa.pins, _aoxa_led_pin)) <= 0) {
+    LogMsg("AOXA: invalid pins %s -- using " AOXA_PINS_DEFAULT, _config_aoxa.pins);
+    _aoxa_leds = AoxaParsePins(AOXA_PINS_DEFAULT, _aoxa_led_pin);
+  }
+  LogMsg("AOXA: %d LEDs on pins %s", _aoxa_leds, _config_aoxa.pins);
+}
+
+/*
+    setup the configuration
+*/
+void AoxaSetup(void)
+{
+  aoxa_config_update();
+  aoxa_pins_setup();
 
   /*
      init the pins
   */
   LogMsg("AOXA: configuring pins for output");
-  for (int led = 0; led < AOXA_LEDS; led++)
+  for (int led = 0; led < _aoxa_leds; led++)
     pinMode(_aoxa_led_pin[led], OUTPUT);
 
   /*
@@ -81,18 +286,36 @@ void AoxaSetup(void)
   LogMsg("AOXA: configuring pins for input");
   pinMode(_aoxa_button_pin, INPUT_PULLUP);
 
-#if DBG
+#if AOXA_SELFTEST
   /*
      switch them on/off
   */
-  for (int led = 0; led < AOXA_LEDS; led++) {
+  for (int led = 0; led < _aoxa_leds; led++) {
     digitalWrite(_aoxa_led_pin[led], HIGH);
     delay(250);
     digitalWrite(_aoxa_led_pin[led], LOW);
     delay(250);
   }
 #endif
-  AoxaChangeMode(_config.aoxa.default_mode);
+
+  if (aoxa_rtc_valid()) {
+    /*
+       resume where we were before the reset
+    */
+    LogMsg("AOXA: resuming mode %s with brightness %d%% after reset", AoxaLookupMode(_aoxa_rtc.mode), _aoxa_rtc.brightness);
+    _aoxa_brightness = _aoxa_rtc.brightness;
+    AoxaChangeMode(_aoxa_rtc.mode);
+    _aoxa_phase = _aoxa_rtc.phase;
+
+    /*
+       the number of LEDs might have changed with the reset
+    */
+    if (_aoxa_phase.fade_pos >= AOXA_FADE_RANGE(_aoxa_leds))
+      _aoxa_phase.fade_pos = AOXA_FADE_RANGE(_aoxa_leds) - 1;
+  }
+  else
+    AoxaChangeMode(_config_aoxa.default_mode);
+  aoxa_rtc_save();
 }
 
 /*
@@ -101,93 +324,40 @@ void AoxaSetup(void)
 void AoxaUpdate(void)
 {
   unsigned long now = millis();
-  static bool button_down = false;
+  static unsigned long button_down = 0;
 
   if (digitalRead(_aoxa_button_pin) == LOW) {
-    button_down = true;
+    if (!button_down)
+      button_down = now;
   }
   else if (button_down) {
     /*
-       the button got released, so choose the next mode
+       the button got released -- a short press chooses the next mode,
+       a long press is only announced
     */
-    button_down = false;
-    LogMsg("AOXA: button released");
-    AoxaNextMode();
+    bool long_press = now - button_down > AOXA_BUTTON_LONGPRESS;
+
+    button_down = 0;
+    LogMsg("AOXA: button released after %s press", long_press ? "long" : "short");
+    if (!long_press)
+      AoxaNextMode();
+    EventPublish(EVENT_AOXA_BUTTON, long_press ? AOXA_BUTTON_LONG_PRESS : AOXA_BUTTON_PRESS);
   }
 
-  if (now > _aoxa_next) {
+  if (_aoxa_next && now >= _aoxa_next) {
     /*
-       it might be the time to change the LEDs
+       it might be the time to change the LEDs -- a mode without frames
+       doesn't schedule any further updates
     */
-    switch (_aoxa_mode) {
-      case AOXA_MODE_FADE:
-        /*
-           fade: back and forth fading
-
-           pos is an virtual spot which moves forth and back (with a higher resolution than the number of LEDs),
-           the leds will be set with an an intensity which depends on the distance to that spot
-        */
-        {
-          static int _pos = 0;
-          static bool _forward = true;
-
-          if (_forward) {
-            if (++_pos >= AOXA_FADE_RANGE) {
-              _pos--;
-              _forward = !_forward;
-            }
-          }
-          else {
-            if (--_pos < 0) {
-              _pos++;
-              _forward = !_forward;
-            }
-          }
-
-          for (int led = 0; led < AOXA_LEDS; led++) {
-            int delta = (double) abs(_pos - (double) led * AOXA_FADE_RANGE / (AOXA_LEDS - 1)) * 1023.0 / AOXA_FADE_RANGE;
-            //int delta = (AOXA_FADE_RANGE - (double) abs(_pos - led * AOXA_FADE_RANGE / AOXA_LEDS)) / AOXA_FADE_RANGE * 1023;
-            analogWrite(_aoxa_led_pin[led], delta);
-          }
-          _aoxa_next = now + _config.aoxa.fade_speed;
-        }
-        break;
-      case AOXA_MODE_FLASH:
-        /*
-           flash: all LEDs will toggle
-        */
-        {
-          static bool _toggle = false;
-
-          _toggle = !_toggle;
-          for (int led = 0; led < AOXA_LEDS; led++)
-            analogWrite(_aoxa_led_pin[led], (_toggle) ? ANALOG_HIGH : ANALOG_LOW);
-          _aoxa_next = now + _config.aoxa.flash_speed;
-        }
-        break;
-      case AOXA_MODE_BLINK:
-        /*
-           blink: in each cycle one random LED will be toggled
-        */
-        {
-          int led = random(AOXA_LEDS);
-          static bool _state[AOXA_LEDS];
-
-          analogWrite(_aoxa_led_pin[led], (_state[led] = !_state[led]) ? ANALOG_LOW : ANALOG_HIGH);
-          _aoxa_next = now + _config.aoxa.blink_speed;
-        }
-        break;
-      case AOXA_MODE_FIRE:
-        /*
-           fire: all LEDs will get a different intensity
-        */
-        {
-          for (int led = 0; led < AOXA_LEDS; led++)
-            analogWrite(_aoxa_led_pin[led], AOXA_FIRE_LOW + random(AOXA_FIRE_HIGH - AOXA_FIRE_LOW));
-          _aoxa_next = now + _config.aoxa.fire_speed;
-        }
-        break;
-    }
+    unsigned long wait;
+
+    aoxa_config_update();
+    if (_aoxa_leds == AOXA_LEDS_FAST)
+      wait = aoxa_frame<AOXA_LEDS_FAST>(0);
+    else
+      wait = aoxa_frame<0>(_aoxa_leds);
+    _aoxa_next = wait ? now + wait : 0;
+    aoxa_rtc_save();
   }
 }
 
@@ -211,28 +381,140 @@ void AoxaChangeMode(int mode)
   if (mode == _aoxa_mode)
     return;
 
-  if (mode == AOXA_MODE_DEFAULT)
-    mode = _config.aoxa.default_mode;
+  if (mode == AOXA_MODE_DEFAULT) {
+    aoxa_config_update();
+    mode = _config_aoxa.default_mode;
+  }
 
   switch (_aoxa_mode = mode) {
     case AOXA_MODE_ON:
       /*
          switch all LEDs on, and don't schedule any updates
       */
-      for (int led = 0; led < AOXA_LEDS; led++)
-        analogWrite(_aoxa_led_pin[led], ANALOG_HIGH);
+      aoxa_write_all(ANALOG_HIGH);
       _aoxa_next = 0;
       break;
     default:
       /*
          switch all LEDs off, and schedule updates only if we are not in OFF mode
       */
-      for (int led = 0; led < AOXA_LEDS; led++)
-        analogWrite(_aoxa_led_pin[led], ANALOG_LOW);
+      aoxa_write_all(ANALOG_LOW);
       _aoxa_next = (_aoxa_mode == AOXA_MODE_OFF) ? 0 : millis();
       break;
   }
-  MqttPublishStat(String(AoxaLookupMode(_aoxa_mode)));
+  aoxa_rtc_save();
+  EventPublish(EVENT_AOXA_MODE, _aoxa_mode);
+}
+
+/*
+   get the time in milli seconds until the next LED update is due
+
+   if no updates are scheduled, a large value is returned
+*/
+unsigned long AoxaNextUpdate(void)
+{
+  unsigned long now = millis();
+
+  if (!_aoxa_next)
+    return ~0UL;
+  return (now < _aoxa_next) ? _aoxa_next - now : 0;
+}
+
+/*
+   switch all LEDs off without changing the mode
+
+   used before a restart, so the mode in the RTC memory is resumed afterwards
+*/
+void AoxaShutdown(void)
+{
+  LogMsg("AOXA: switching off LEDs for shutdown");
+
+  for (int led = 0; led < _aoxa_leds; led++)
+    analogWrite(_aoxa_led_pin[led], _aoxa_led_value[led] = ANALOG_LOW);
+}
+
+/*
+   get the number of LEDs
+*/
+int AoxaLeds(void)
+{
+  return _aoxa_leds;
+}
+
+/*
+   get the GPIO of the given LED
+*/
+int AoxaLedPin(int led)
+{
+  return (led >= 0 && led < _aoxa_leds) ? _aoxa_led_pin[led] : -1;
+}
+
+/*
+   get the values last written to the LEDs
+*/
+int AoxaGetFrame(int *values)
+{
+  memcpy(values, _aoxa_led_value, _aoxa_leds * sizeof(values[0]));
+  return _aoxa_leds;
+}
+
+/*
+   parse a comma separated list of GPIOs into the given array
+*/
+int AoxaParsePins(const char *text, int *pins)
+{
+  int leds = 0;
+
+  while (*text) {
+    char *end;
+    int pin = strtol(text, &end, 10);
+
+    if (end == text || leds >= AOXA_LEDS_MAX || !digitalPinCanOutput(pin) || pin == _aoxa_button_pin)
+      return -1;
+    for (int led = 0; led < leds; led++)
+      if (pins[led] == pin)
+        return -1;
+    pins[leds++] = pin;
+    while (*end == ' ')
+      end++;
+    if (*end == ',')
+      end++;
+    else if (*end)
+      return -1;
+    text = end;
+  }
+  return leds;
+}
+
+/*
+   get the brightness in percent
+*/
+int AoxaGetBrightness(void)
+{
+  return _aoxa_brightness;
+}
+
+/*
+   set the brightness in percent
+*/
+void AoxaSetBrightness(int brightness)
+{
+  brightness = min(max(brightness, AOXA_BRIGHTNESS_MIN), AOXA_BRIGHTNESS_MAX);
+
+  LogMsg("AOXA: changing brightness from %d%% to %d%%", _aoxa_brightness, brightness);
+
+  if (brightness == _aoxa_brightness)
+    return;
+
+  _aoxa_brightness = brightness;
+  if (_aoxa_mode == AOXA_MODE_ON) {
+    /*
+       there are no updates in this mode, so apply it here
+    */
+    aoxa_write_all(ANALOG_HIGH);
+  }
+  aoxa_rtc_save();
+  EventPublish(EVENT_AOXA_BRIGHTNESS, _aoxa_brightness);
 }
 
 /*
@@ -247,6 +529,57 @@ void AoxaNextMode(void)
   AoxaChangeMode(new_mode);
 }
 
+/*
+   recall the given preset
+*/
+bool AoxaRecallPreset(int preset)
+{
+  CONFIG_PRESET entry;
+
+  if (preset < 1 || preset > AOXA_PRESETS)
+    return false;
+  ConfigGet(offsetof(CONFIG, presets) + (preset - 1) * sizeof(CONFIG_PRESET), sizeof(CONFIG_PRESET), &entry);
+  if (!entry.used)
+    return false;
+  if (entry.mode < AOXA_MODE_FIRST || entry.mode > AOXA_MODE_LAST) {
+    LogMsg("AOXA: preset %d holds the invalid mode %d", preset, entry.mode);
+    return false;
+  }
+
+  LogMsg("AOXA: recalling preset %d", preset);
+  _aoxa_override.fade_speed = entry.fade_speed ? min(max((int) entry.fade_speed, AOXA_FADE_SPEED_MIN), AOXA_FADE_SPEED_MAX) : 0;
+  _aoxa_override.flash_speed = entry.flash_speed ? min(max((int) entry.flash_speed, AOXA_FLASH_SPEED_MIN), AOXA_FLASH_SPEED_MAX) : 0;
+  _aoxa_override.blink_speed = entry.blink_speed ? min(max((int) entry.blink_speed, AOXA_BLINK_SPEED_MIN), AOXA_BLINK_SPEED_MAX) : 0;
+  _aoxa_override.fire_speed = entry.fire_speed ? min(max((int) entry.fire_speed, AOXA_FIRE_SPEED_MIN), AOXA_FIRE_SPEED_MAX) : 0;
+  AoxaSetBrightness(entry.brightness);
+  AoxaChangeMode(entry.mode);
+  return true;
+}
+
+/*
+   store the current mode, brightness and speeds as the given preset
+*/
+bool AoxaSavePreset(int preset)
+{
+  CONFIG_PRESET entry;
+
+  if (preset < 1 || preset > AOXA_PRESETS)
+    return false;
+
+  LogMsg("AOXA: saving preset %d", preset);
+  aoxa_config_update();
+  memset(&entry, 0, sizeof(entry));
+  entry.used = true;
+  entry.mode = _aoxa_mode;
+  entry.brightness = _aoxa_brightness;
+  entry.fade_speed = AOXA_SPEED(fade_speed);
+  entry.flash_speed = AOXA_SPEED(flash_speed);
+  entry.blink_speed = AOXA_SPEED(blink_speed);
+  entry.fire_speed = AOXA_SPEED(fire_speed);
+  ConfigSet(offsetof(CONFIG, presets) + (preset - 1) * sizeof(CONFIG_PRESET), sizeof(CONFIG_PRESET), &entry);
+  return true;
+}
+
 /*
    lookup the given mode
 */
@@ -263,4 +596,20 @@ const char *AoxaLookupMode(int mode)
       AOXA_MODE_CASE(FIRE);
   }
   return NULL;
+}
+
+/*
+   parse the given mode name (case insensitive)
+
+   returns AOXA_MODE_LAST_PLUS_ONE if the name is unknown
+*/
+int AoxaParseMode(const char *name, int len)
+{
+  for (int mode = AOXA_MODE_FIRST; mode <= AOXA_MODE_LAST; mode++) {
+    const char *mode_name = AoxaLookupMode(mode);
+
+    if (mode_name && (int) strlen(mode_name) == len && !strncasecmp(name, mode_name, len))
+      return mode;
+  }
+  return AOXA_MODE_LAST_PLUS_ONE;
 }/**/
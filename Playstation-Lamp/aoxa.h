@@ -26,12 +26,18 @@
 #ifndef __AOXA_H__
 #define __AOXA_H__ 1
 
-#define AOXA_LEDS                 4
+/*
+   the LEDs are driven by the LEDC channels of the ESP32, so there are
+   at most 16 of them -- the GPIOs are configured as a comma separated
+   list, the number of GPIOs given is the number of LEDs
+*/
+#define AOXA_LEDS_MAX             16
+#define AOXA_PINS_DEFAULT         "16,17,21,22"
 
 #define AOXA_FADE_SPEED_DEFAULT   100
 #define AOXA_FADE_SPEED_MIN       10
 #define AOXA_FADE_SPEED_MAX       1000
-#define AOXA_FADE_RANGE           (AOXA_LEDS * 25)
+#define AOXA_FADE_RANGE(leds)     ((leds) * 25)
 
 #define AOXA_BLINK_SPEED_DEFAULT  100
 #define AOXA_BLINK_SPEED_MIN      10
@@ -45,12 +51,33 @@
 #define AOXA_FIRE_SPEED_MIN       10
 #define AOXA_FIRE_SPEED_MAX       500
 
+#define AOXA_BRIGHTNESS_MIN       0
+#define AOXA_BRIGHTNESS_MAX       100
+
+/*
+   number of presets -- they are numbered from 1 to AOXA_PRESETS
+*/
+#define AOXA_PRESETS              8
+
 #define AOXA_FIRE_LOW             130
 #define AOXA_FIRE_HIGH            300
 
 #define ANALOG_LOW                0
 #define ANALOG_HIGH               1023
 
+/*
+   pressing the button longer than this is a long press [ms]
+*/
+#define AOXA_BUTTON_LONGPRESS     1000
+
+/*
+   button events
+*/
+enum AOXA_BUTTON {
+  AOXA_BUTTON_PRESS = 0,
+  AOXA_BUTTON_LONG_PRESS,
+};
+
 /*
    STATE handling
 
@@ -94,9 +121,80 @@ void AoxaChangeMode(int mode);
 */
 void AoxaNextMode(void);
 
+/*
+   get the time in milli seconds until the next LED update is due
+
+   if no updates are scheduled, a large value is returned
+*/
+unsigned long AoxaNextUpdate(void);
+
+/*
+   switch all LEDs off without changing the mode
+*/
+void AoxaShutdown(void);
+
+/*
+   get the number of LEDs
+*/
+int AoxaLeds(void);
+
+/*
+   get the GPIO of the given LED
+*/
+int AoxaLedPin(int led);
+
+/*
+   get the values last written to the LEDs into the given array, which has
+   to hold AOXA_LEDS_MAX entries -- the values are in the range of
+   ANALOG_LOW to ANALOG_HIGH
+
+   returns the number of LEDs
+*/
+int AoxaGetFrame(int *values);
+
+/*
+   parse a comma separated list of GPIOs into the given array, which has
+   to hold AOXA_LEDS_MAX entries
+
+   returns the number of GPIOs or -1 if the list is invalid
+*/
+int AoxaParsePins(const char *text, int *pins);
+
+/*
+   get the brightness in percent
+*/
+int AoxaGetBrightness(void);
+
+/*
+   set the brightness in percent
+*/
+void AoxaSetBrightness(int brightness);
+
+/*
+   recall the given preset
+
+   the speeds of the preset override the configured ones until the next
+   preset is recalled -- nothing is written to the flash
+
+   returns false if the preset is not used or holds an invalid mode
+*/
+bool AoxaRecallPreset(int preset);
+
+/*
+   store the current mode, brightness and speeds as the given preset
+*/
+bool AoxaSavePreset(int preset);
+
 /*
    lookup the given mode
 */
 const char *AoxaLookupMode(int mode);
 
+/*
+   parse the given mode name (case insensitive)
+
+   returns AOXA_MODE_LAST_PLUS_ONE if the name is unknown
+*/
+int AoxaParseMode(const char *name, int len);
+
 #endif
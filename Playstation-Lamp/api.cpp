@@ -0,0 +1,345 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the JSON API
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include "config.h"
+#include "api.h"
+#include "http.h"
+#include "json.h"
+#include "wifi.h"
+#if FEATURE_MQTT
+#include "mqtt.h"
+#endif
+#if FEATURE_NTP
+#include "ntp.h"
+#endif
+#include "aoxa.h"
+#include "event.h"
+#include "journal.h"
+
+#if FEATURE_HTTP
+
+/*
+   start a JSON response
+*/
+static void api_begin(SERVER_REQUEST *request, WRITER *w, JSON *json, int code)
+{
+  WriterBegin(w, request->client, code, "application/json");
+  WriterHeader(w, "Cache-Control", "no-store");
+  WriterBody(w, WRITER_CHUNKED);
+  JsonBegin(json, w);
+}
+
+/*
+   finish a JSON response
+*/
+static void api_end(WRITER *w, JSON *json)
+{
+  JsonEnd(json);
+  if (!WriterEnd(w))
+    LogMsg("API: client dropped the response after %lu bytes", w->bytes);
+}
+
+/*
+   answer the request with an error
+*/
+static void api_error(SERVER_REQUEST *request, WRITER *w, int code, const char *text, const char *name = NULL)
+{
+  JSON json;
+
+  api_begin(request, w, &json, code);
+  JsonString(&json, "error", text);
+  if (name)
+    JsonString(&json, "field", name);
+  api_end(w, &json);
+}
+
+/*
+   check if the request carries a JSON body
+
+   returns 1 for a PUT or POST with a body, 0 for other methods and -1 if
+   the request was answered with an error
+*/
+static int api_body(SERVER_REQUEST *request, WRITER *w)
+{
+  if (request->method != SERVER_METHOD_POST && request->method != SERVER_METHOD_PUT)
+    return 0;
+  if (!request->body || !request->body_len) {
+    api_error(request, w, 400, "JSON body expected");
+    return -1;
+  }
+  return 1;
+}
+
+/*
+   answer with the state of the lamp
+*/
+static void api_state(SERVER_REQUEST *request, WRITER *w)
+{
+  JSON json;
+
+  api_begin(request, w, &json, 200);
+  JsonString(&json, "mode", AoxaLookupMode(AoxaGetMode()));
+  JsonInt(&json, "brightness", AoxaGetBrightness());
+  JsonObjectBegin(&json, "wifi");
+  JsonBool(&json, "connected", WifiConnected());
+  JsonInt(&json, "rssi", WifiGetRSSI());
+  JsonObjectEnd(&json);
+#if FEATURE_MQTT
+  JsonObjectBegin(&json, "mqtt");
+  JsonBool(&json, "connected", MqttConnected());
+  JsonObjectEnd(&json);
+#endif
+  api_end(w, &json);
+}
+
+/*
+   GET the state of the lamp, or PUT/POST changes to it
+
+   the whole body is checked before anything is changed
+*/
+void ApiState(SERVER_REQUEST *request, WRITER *w)
+{
+  JSON_PARSER parser;
+  char *name, *value;
+  int type, rc;
+  int mode = AOXA_MODE_LAST_PLUS_ONE;   // not given -- -1 is AOXA_MODE_DEFAULT
+  int brightness = -1, preset = -1;
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+  if ((rc = api_body(request, w)) <= 0) {
+    if (!rc)
+      api_state(request, w);
+    return;
+  }
+
+  JsonParseBegin(&parser, request->body);
+  while ((rc = JsonParseMember(&parser, &name, &value, &type)) > 0) {
+    if (!strcmp(name, "mode") && type == JSON_TYPE_STRING) {
+      if ((mode = AoxaParseMode(value, strlen(value))) == AOXA_MODE_LAST_PLUS_ONE)
+        return api_error(request, w, 400, "unknown mode", name);
+    }
+    else if (!strcmp(name, "brightness") && type == JSON_TYPE_NUMBER)
+      brightness = atoi(value);
+    else if (!strcmp(name, "preset") && type == JSON_TYPE_NUMBER)
+      preset = atoi(value);
+    else
+      return api_error(request, w, 400, "unknown member", name);
+  }
+  if (rc < 0)
+    return api_error(request, w, 400, "malformed JSON");
+
+  /*
+     the preset comes first, so the explicit values override it
+  */
+  if (preset >= 0 && !AoxaRecallPreset(preset))
+    return api_error(request, w, 400, "unknown preset", "preset");
+  if (mode != AOXA_MODE_LAST_PLUS_ONE)
+    AoxaChangeMode(mode);
+  if (brightness >= 0)
+    AoxaSetBrightness(brightness);
+  api_state(request, w);
+}
+
+/*
+   switch to the mode given in the path
+*/
+void ApiMode(SERVER_REQUEST *request, WRITER *w)
+{
+  const char *name = request->path + strlen(API_PATH_MODE);
+  int mode;
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+  if ((mode = AoxaParseMode(name, strlen(name))) == AOXA_MODE_LAST_PLUS_ONE)
+    return api_error(request, w, 404, "unknown mode");
+  AoxaChangeMode(mode);
+  api_state(request, w);
+}
+
+/*
+   GET the config fields, or PUT/POST some of them
+
+   the fields are taken over into a copy of the config, which is only
+   written back if the whole body is valid -- secrets are reported as
+   null, and null leaves a field untouched
+*/
+void ApiConfig(SERVER_REQUEST *request, WRITER *w)
+{
+  JSON json;
+  int body;
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  if ((body = api_body(request, w)) < 0)
+    return;
+  if (body) {
+    JSON_PARSER parser;
+    CONFIG config;
+    const CONFIG_FIELD *field;
+    char *name, *value;
+    int type, rc;
+
+    ConfigGet(0, sizeof(CONFIG), &config);
+    JsonParseBegin(&parser, request->body);
+    while ((rc = JsonParseMember(&parser, &name, &value, &type)) > 0) {
+      if (!(field = ConfigLookupField(name)))
+        return api_error(request, w, 400, "unknown field", name);
+      if (type == JSON_TYPE_NULL)
+        continue;
+      if ((field->type == CONFIG_FIELD_STRING && type != JSON_TYPE_STRING) ||
+          (field->type == CONFIG_FIELD_INT && type != JSON_TYPE_NUMBER) ||
+          !ConfigParseField(field, value, strlen(value), &config))
+        return api_error(request, w, 400, "bad value", name);
+    }
+    if (rc < 0)
+      return api_error(request, w, 400, "malformed JSON");
+    ConfigSet(0, sizeof(CONFIG), &config);
+  }
+
+  api_begin(request, w, &json, 200);
+  for (int n = 0; n < ConfigFields(); n++) {
+    const CONFIG_FIELD *field = ConfigField(n);
+    const byte *value = (const byte *) &_config + field->offset;
+
+    if (field->flags & CONFIG_FIELD_SECRET)
+      JsonNull(&json, field->name);
+    else if (field->type == CONFIG_FIELD_STRING)
+      JsonString(&json, field->name, (const char *) value);
+    else if (field->type == CONFIG_FIELD_INT)
+      JsonInt(&json, field->name, *(const int *) value);
+  }
+  api_end(w, &json);
+}
+
+/*
+   GET the information about the device
+*/
+void ApiInfo(SERVER_REQUEST *request, WRITER *w)
+{
+  JSON json;
+
+  if (!HttpAuthorized(request, w, true))
+    return;
+
+  api_begin(request, w, &json, 200);
+  JsonString(&json, "version", GIT_VERSION);
+  JsonString(&json, "build", __DATE__ " " __TIME__);
+  JsonString(&json, "name", _config.device.name);
+  JsonUnsigned(&json, "uptime", millis() / 1000);
+#if FEATURE_NTP
+  JsonUnsigned(&json, "up_since", NtpUpSince());
+#endif
+  JsonUnsigned(&json, "heap_free", ESP.getFreeHeap());
+
+  JsonObjectBegin(&json, "wifi");
+  JsonString(&json, "ssid", WifiGetSSID());
+  JsonInt(&json, "rssi", WifiGetRSSI());
+  JsonString(&json, "mac", WifiGetMacAddr());
+  JsonString(&json, "ip", WifiGetIpAddr());
+  JsonObjectEnd(&json);
+
+#if FEATURE_MQTT
+  JsonObjectBegin(&json, "mqtt");
+  JsonString(&json, "server", _config.mqtt.server);
+  JsonInt(&json, "port", _config.mqtt.port);
+  JsonBool(&json, "connected", MqttConnected());
+  JsonObjectEnd(&json);
+#endif
+
+  JsonArrayBegin(&json, "led_pins");
+  for (int led = 0; led < AoxaLeds(); led++)
+    JsonInt(&json, NULL, AoxaLedPin(led));
+  JsonArrayEnd(&json);
+
+  JsonObjectBegin(&json, "boot_phases");
+  for (int n = 0; n < BootPhases(); n++)
+    JsonUnsigned(&json, BootPhaseName(n), BootPhaseTime(n));
+  JsonObjectEnd(&json);
+
+  JsonObjectBegin(&json, "config");
+  JsonUnsigned(&json, "commits", ConfigCommits());
+  JsonUnsigned(&json, "bytes", ConfigBytesWritten());
+  JsonObjectEnd(&json);
+
+  JsonObjectBegin(&json, "journal");
+  JsonUnsigned(&json, "records", JournalRecords());
+  JsonUnsigned(&json, "bytes", JournalBytesWritten());
+  JsonUnsigned(&json, "erases", JournalErases());
+  JsonObjectEnd(&json);
+
+  JsonObjectBegin(&json, "events");
+  JsonUnsigned(&json, "mode", EventCount(EVENT_AOXA_MODE));
+  JsonUnsigned(&json, "wifi", EventCount(EVENT_WIFI));
+  JsonUnsigned(&json, "mqtt", EventCount(EVENT_MQTT));
+  JsonUnsigned(&json, "config", EventCount(EVENT_CONFIG));
+  JsonUnsigned(&json, "dropped", EventDropped());
+  JsonObjectEnd(&json);
+
+  JsonObjectBegin(&json, "http");
+  JsonUnsigned(&json, "requests", ServerStats()->requests);
+  JsonUnsigned(&json, "reused", ServerStats()->reused);
+  JsonUnsigned(&json, "rate_limited", ServerStats()->rate_limited);
+  JsonUnsigned(&json, "busy", ServerStats()->busy);
+  JsonUnsigned(&json, "rejected", ServerStats()->rejected);
+  JsonUnsigned(&json, "deferred", ServerStats()->deferred);
+  JsonUnsigned(&json, "timeouts", ServerStats()->timeouts);
+  JsonObjectEnd(&json);
+  api_end(w, &json);
+}
+
+/*
+   GET the WiFi networks found by the background scan -- the list is
+   served from the cache, age is -1 while the first scan is running
+*/
+void ApiNetworks(SERVER_REQUEST *request, WRITER *w)
+{
+  const WIFI_NETWORK *networks;
+  int count;
+  JSON json;
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  count = WifiGetNetworks(&networks);
+  api_begin(request, w, &json, 200);
+  JsonInt(&json, "age", WifiGetNetworksAge());
+  JsonArrayBegin(&json, "networks");
+  for (int n = 0; n < count; n++) {
+    JsonObjectBegin(&json, NULL);
+    JsonString(&json, "ssid", networks[n].ssid);
+    JsonInt(&json, "rssi", networks[n].rssi);
+    JsonInt(&json, "channel", networks[n].channel);
+    JsonBool(&json, "secure", networks[n].secure);
+    JsonObjectEnd(&json);
+  }
+  JsonArrayEnd(&json);
+  api_end(w, &json);
+}
+
+#endif
+
+/**/
@@ -0,0 +1,58 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the JSON API
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __API_H__
+#define __API_H__ 1
+
+#include "config.h"
+#include "server.h"
+
+/*
+   the endpoints of the JSON API
+
+     /api/state         GET the state, PUT or POST {"mode","brightness","preset"}
+     /api/mode/<name>   switch to the given mode and return the state
+     /api/config        GET the config fields, PUT or POST some of them
+     /api/info          GET the information about the device
+     /api/networks      GET the WiFi networks found by the background scan
+*/
+#define API_PATH_STATE    "/api/state"
+#define API_PATH_MODE     "/api/mode/"
+#define API_PATH_CONFIG   "/api/config"
+#define API_PATH_INFO     "/api/info"
+#define API_PATH_NETWORKS "/api/networks"
+
+/*
+   the handlers of the endpoints
+*/
+void ApiState(SERVER_REQUEST *request, WRITER *w);
+void ApiMode(SERVER_REQUEST *request, WRITER *w);
+void ApiConfig(SERVER_REQUEST *request, WRITER *w);
+void ApiInfo(SERVER_REQUEST *request, WRITER *w);
+void ApiNetworks(SERVER_REQUEST *request, WRITER *w);
+
+#endif
+
+/**/
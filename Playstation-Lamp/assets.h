@@ -0,0 +1,87 @@
+/*
+  Playstation-Lamp
+
+  the static web assets -- generated by make-assets.py, don't edit
+*/
+
+#ifndef __ASSETS_H__
+#define __ASSETS_H__ 1
+
+#include <stdint.h>
+
+#define ASSET_LIVE_JS_HASH  "3b2e9223a6c5f16d"
+#define ASSET_STYLES_CSS_HASH  "9aa683804a252ff8"
+
+typedef struct _asset {
+  const char *path;
+  const char *type;
+  const char *etag;
+  const uint8_t *data;   // compressed with gzip
+  int len;
+} ASSET;
+
+static const uint8_t _asset_live_js[] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x51, 0xb1, 0x6e, 0xc2, 0x30,
+  0x10, 0xdd, 0xf3, 0x15, 0x2e, 0x4b, 0x9c, 0x52, 0x19, 0x68, 0xa7, 0x2a, 0xa5, 0x95, 0x8a, 0x18,
+  0x5a, 0x55, 0xed, 0xc0, 0x88, 0x18, 0x4c, 0x7c, 0x80, 0xa5, 0x60, 0xa7, 0xf6, 0x25, 0x14, 0x55,
+  0xfc, 0x7b, 0xcf, 0x49, 0x80, 0x22, 0x41, 0xbb, 0x24, 0xf6, 0xbd, 0x7b, 0xef, 0xee, 0x3d, 0xf3,
+  0x45, 0x69, 0x32, 0xd4, 0xd6, 0x30, 0x9e, 0xb0, 0xef, 0xa8, 0x92, 0x8e, 0x79, 0x5b, 0xba, 0x0c,
+  0xd8, 0x90, 0x19, 0xd8, 0xb0, 0x71, 0x05, 0x06, 0x27, 0x75, 0x85, 0xc7, 0x3d, 0x59, 0xe8, 0x1e,
+  0x84, 0x8a, 0x7f, 0x5a, 0x38, 0xb9, 0x06, 0x1f, 0x27, 0x69, 0xcd, 0x59, 0x5b, 0x15, 0x18, 0xca,
+  0x66, 0xe5, 0x9a, 0x60, 0xf1, 0x59, 0x82, 0xdb, 0x4e, 0x20, 0x87, 0x0c, 0xad, 0xe3, 0xf1, 0xbc,
+  0x44, 0xb4, 0x46, 0xf8, 0x8d, 0xc6, 0x6c, 0xb5, 0xe7, 0xcc, 0x9d, 0x5e, 0xae, 0xd0, 0x80, 0xf7,
+  0x97, 0x99, 0x1d, 0x6d, 0x8a, 0x12, 0xa7, 0x86, 0x66, 0x0d, 0xe3, 0x23, 0x21, 0x9e, 0x75, 0x5a,
+  0x91, 0x1c, 0xd4, 0x09, 0x7d, 0x09, 0x38, 0xce, 0x21, 0x1c, 0x9f, 0xb7, 0x2f, 0x8a, 0xc7, 0x01,
+  0x0f, 0x03, 0x1b, 0x53, 0x42, 0x2a, 0x55, 0x3b, 0x7a, 0xd3, 0x1e, 0xc1, 0x00, 0xad, 0xe6, 0x51,
+  0x22, 0xc4, 0x37, 0xec, 0x98, 0x03, 0x1c, 0x82, 0x08, 0x10, 0x89, 0xbf, 0x4e, 0x3e, 0xde, 0x45,
+  0x21, 0x9d, 0x07, 0x0e, 0x42, 0x49, 0x94, 0xa4, 0x17, 0x0c, 0x0b, 0x84, 0x2f, 0x1c, 0x59, 0x43,
+  0x4a, 0x48, 0x6d, 0x75, 0xbb, 0x08, 0x40, 0x1a, 0xe9, 0x05, 0xe3, 0x87, 0x9d, 0x24, 0x09, 0x57,
+  0xd0, 0xae, 0xc5, 0xae, 0x86, 0xc3, 0x5f, 0xd6, 0x93, 0xe8, 0x78, 0x16, 0x95, 0xcc, 0x4b, 0x38,
+  0x28, 0x1d, 0x81, 0x34, 0xda, 0xfd, 0x65, 0xa1, 0x7e, 0x8a, 0xf3, 0x16, 0x6a, 0xe8, 0x82, 0x85,
+  0xcd, 0x4a, 0xe7, 0xc0, 0x78, 0x48, 0x48, 0x64, 0x74, 0x56, 0x0e, 0x8c, 0xc8, 0xc1, 0x2c, 0x71,
+  0xc5, 0x1e, 0x1b, 0x66, 0x7b, 0x4d, 0xa2, 0xba, 0xc9, 0xc1, 0xda, 0x56, 0x30, 0x0a, 0xad, 0x0d,
+  0x2b, 0x97, 0x1e, 0xeb, 0xeb, 0x3f, 0x6a, 0x0f, 0xe7, 0xd4, 0x64, 0x51, 0x80, 0x51, 0x8d, 0xda,
+  0x21, 0xaa, 0xcc, 0x01, 0x59, 0x6f, 0xa3, 0xa2, 0xc7, 0x29, 0xa4, 0x89, 0x13, 0x52, 0x5f, 0x58,
+  0xc7, 0x78, 0x30, 0x64, 0xc8, 0x4c, 0x3f, 0xa5, 0xdf, 0xa9, 0x26, 0x55, 0xba, 0xdd, 0x56, 0x78,
+  0x3f, 0x7d, 0x6a, 0x66, 0xc2, 0xe3, 0x36, 0x07, 0x61, 0x0b, 0x99, 0x69, 0xdc, 0x06, 0xaa, 0x18,
+  0xb0, 0x2e, 0x7d, 0xef, 0xd9, 0x75, 0xc3, 0xa7, 0x26, 0xd6, 0x63, 0x83, 0xfe, 0xed, 0x5d, 0x13,
+  0xf2, 0x2e, 0xe1, 0x49, 0xfa, 0x03, 0xd6, 0x27, 0x2c, 0xc7, 0x15, 0x03, 0x00, 0x00,
+};
+
+static const uint8_t _asset_styles_css[] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x52, 0xd9, 0xae, 0xdb, 0x20,
+  0x10, 0xfd, 0x95, 0x2b, 0x45, 0x7d, 0x2b, 0xc8, 0x4b, 0xa2, 0xba, 0xf0, 0x35, 0x60, 0xc6, 0xf6,
+  0x28, 0x18, 0x2c, 0xc0, 0xcd, 0x4d, 0x2d, 0xfe, 0xbd, 0xe0, 0x45, 0xcd, 0x72, 0x2b, 0x15, 0x5e,
+  0xc6, 0x0c, 0xe3, 0xb3, 0x70, 0x86, 0x30, 0xea, 0xef, 0xd2, 0xaa, 0xfb, 0x22, 0x45, 0x7b, 0xed,
+  0x9d, 0x9d, 0x8d, 0x62, 0xa7, 0x6e, 0x5d, 0x71, 0x3d, 0x1f, 0x85, 0xeb, 0xd1, 0xb0, 0xd2, 0xc1,
+  0xc8, 0x27, 0xa1, 0x14, 0x9a, 0x9e, 0x15, 0xbc, 0xb3, 0x26, 0x90, 0x4e, 0x8c, 0xa8, 0xef, 0xcc,
+  0x0b, 0xe3, 0x89, 0x07, 0x87, 0x1d, 0x6f, 0xad, 0xb6, 0x8e, 0x9d, 0xaa, 0x22, 0x6f, 0x1e, 0xe0,
+  0x33, 0x10, 0xa1, 0xb1, 0x37, 0xac, 0x05, 0x13, 0xc0, 0x6d, 0x63, 0x1e, 0x7f, 0xc3, 0xfa, 0xbf,
+  0x88, 0x66, 0x9a, 0xc3, 0x72, 0x43, 0x15, 0x06, 0xf6, 0xb3, 0xf8, 0xf6, 0xda, 0x96, 0x73, 0x08,
+  0xd6, 0x2c, 0xd2, 0x3a, 0x05, 0x2e, 0x81, 0x6e, 0x05, 0x71, 0x42, 0xe1, 0xec, 0x59, 0x41, 0xeb,
+  0xcc, 0xe9, 0x91, 0x77, 0xd9, 0x34, 0xa5, 0x14, 0x07, 0x8b, 0x4d, 0x05, 0xd7, 0x68, 0x80, 0x0c,
+  0x80, 0xfd, 0x10, 0x58, 0x45, 0xcf, 0x79, 0xe6, 0x01, 0x87, 0x56, 0xf9, 0x60, 0xa3, 0x50, 0x16,
+  0x89, 0x03, 0xb9, 0x81, 0xbc, 0x62, 0x20, 0xc1, 0x25, 0x59, 0x18, 0xd0, 0x1a, 0xa2, 0x66, 0x27,
+  0x72, 0x91, 0x20, 0x2f, 0x9e, 0xff, 0xb3, 0xd1, 0xce, 0xce, 0x27, 0xdc, 0xc9, 0xe2, 0xaa, 0xd5,
+  0x4e, 0xa2, 0xc5, 0x70, 0x4f, 0xbd, 0x66, 0x57, 0xc2, 0x06, 0xfb, 0x0b, 0xdc, 0x72, 0x34, 0x4a,
+  0x5a, 0x44, 0xea, 0x6f, 0x18, 0xda, 0x61, 0x39, 0x9c, 0xad, 0x5e, 0x25, 0x75, 0x45, 0xde, 0xff,
+  0x67, 0xec, 0x6d, 0x13, 0x29, 0xad, 0x56, 0x0f, 0x12, 0xb3, 0x4b, 0x91, 0x0e, 0x20, 0x92, 0x77,
+  0xcb, 0xdb, 0x64, 0xa4, 0x6d, 0xba, 0x99, 0xca, 0xc7, 0x96, 0x86, 0x2e, 0x70, 0x85, 0x7e, 0xd2,
+  0xe2, 0xce, 0xd0, 0xac, 0x0e, 0x4a, 0x6d, 0xdb, 0xeb, 0xc1, 0xa3, 0x58, 0x17, 0x1f, 0xd1, 0x90,
+  0xcd, 0xba, 0xfa, 0x5c, 0x4c, 0x9f, 0x91, 0x8e, 0xbe, 0x7f, 0x87, 0x38, 0x86, 0x24, 0xd4, 0x3f,
+  0xea, 0xf2, 0x9d, 0xea, 0xa1, 0xfd, 0x92, 0x88, 0x7e, 0x24, 0x4b, 0x3a, 0x6b, 0xc3, 0x33, 0x55,
+  0x97, 0x2f, 0x47, 0xda, 0x3b, 0x00, 0x23, 0xfb, 0xa7, 0xa8, 0xd6, 0xe7, 0xa6, 0x3b, 0xcb, 0x48,
+  0x1d, 0xa8, 0x97, 0x8e, 0x28, 0xab, 0xa6, 0x6a, 0xe2, 0x49, 0x83, 0xf2, 0x1f, 0x7e, 0x12, 0x66,
+  0xf9, 0x52, 0xd1, 0xfe, 0xf4, 0x34, 0xa3, 0xf3, 0x3d, 0x26, 0xfb, 0xd7, 0x1e, 0xfd, 0x23, 0x68,
+  0x4f, 0xe9, 0xbb, 0xa4, 0xa8, 0x7c, 0x11, 0xbd, 0xbf, 0x8f, 0x5e, 0xc6, 0x3f, 0x9c, 0xec, 0x97,
+  0x01, 0x5c, 0x03, 0x00, 0x00,
+};
+
+static const ASSET _assets[] = {
+  { "/live.js", "application/javascript", "\"3b2e9223a6c5f16d\"", _asset_live_js, sizeof(_asset_live_js) },
+  { "/styles.css", "text/css", "\"9aa683804a252ff8\"", _asset_styles_css, sizeof(_asset_styles_css) },
+};
+
+#endif
+
+/**/
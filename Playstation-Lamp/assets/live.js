@@ -0,0 +1,33 @@
+/*
+   Playstation-Lamp
+
+   keeps the main page up to date with the state and the LED frames
+   pushed by the lamp -- this is the source, make-assets.py minifies
+   and compresses it into assets.h
+*/
+
+(function () {
+  var source = new EventSource('/api/events?frames');
+  var mode = document.querySelector('button.switch');
+  var brightness = document.querySelector("input[name='brightness']");
+  var leds = document.getElementById('leds');
+
+  source.addEventListener('state', function (e) {
+    var state = JSON.parse(e.data);
+
+    mode.textContent = state.mode;
+    if (document.activeElement !== brightness)
+      brightness.value = state.brightness;
+  });
+
+  source.addEventListener('frame', function (e) {
+    var frame = JSON.parse(e.data);
+
+    while (leds.children.length > frame.length)
+      leds.removeChild(leds.lastChild);
+    while (leds.children.length < frame.length)
+      leds.appendChild(document.createElement('span'));
+    for (var n = 0; n < frame.length; n++)
+      leds.children[n].style.opacity = 0.1 + 0.9 * frame[n] / 1023;
+  });
+})();
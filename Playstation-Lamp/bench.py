@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+#
+#  Playstation-Lamp
+#
+#  (c) 2020 Christian.Lorenz@gromeck.de
+#
+#  measure the latency and the throughput of the web server of a lamp
+#
+#  usage: bench.py [-u <user>:<password>] [-n <requests>] <host> [<path> ...]
+#
+#  the paths are requested in turn, once with a new connection for each
+#  request and once over one kept connection, and once more with all
+#  requests of a round pipelined -- the default paths are the pages of
+#  the configuration, as they are walked through by a user
+#
+#  run it before and after a change of the server, e.g.
+#
+#  ./bench.py -u admin:secret -n 200 lamp.local
+#
+#  the admission control of the lamp answers more than SERVER_BURST
+#  requests in a row with 429 -- raise SERVER_RATE and SERVER_BURST in
+#  server.h for the measurement
+#
+
+import argparse
+import base64
+import socket
+import statistics
+import sys
+import time
+
+PATHS = ["/config", "/config/device", "/config/wifi", "/config/leds", "/info", "/api/state"]
+
+
+def request(path, host, auth, keep_alive):
+    lines = [
+        "GET %s HTTP/1.1" % path,
+        "Host: %s" % host,
+        "Accept-Encoding: identity",
+        "Connection: %s" % ("keep-alive" if keep_alive else "close"),
+    ]
+    if auth:
+        lines.append("Authorization: Basic %s" % base64.b64encode(auth.encode()).decode())
+    return ("\r\n".join(lines) + "\r\n\r\n").encode()
+
+
+class Reader:
+    # read responses from a socket, chunked or with a Content-Length
+
+    def __init__(self, sock):
+        self.sock = sock
+        self.data = b""
+
+    def fill(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise EOFError("connection closed")
+        self.data += data
+
+    def line(self):
+        while b"\r\n" not in self.data:
+            self.fill()
+        line, self.data = self.data.split(b"\r\n", 1)
+        return line
+
+    def take(self, n):
+        while len(self.data) < n:
+            self.fill()
+        data, self.data = self.data[:n], self.data[n:]
+        return data
+
+    def response(self):
+        status = int(self.line().split()[1])
+        headers = {}
+        while True:
+            line = self.line()
+            if not line:
+                break
+            name, value = line.decode().split(":", 1)
+            headers[name.strip().lower()] = value.strip()
+        size = 0
+        if headers.get("transfer-encoding") == "chunked":
+            while True:
+                n = int(self.line(), 16)
+                size += len(self.take(n + 2)) - 2
+                if not n:
+                    break
+        elif "content-length" in headers:
+            size = len(self.take(int(headers["content-length"])))
+        return status, size, headers.get("connection", "keep-alive").lower() != "close"
+
+
+def connect(host, port):
+    sock = socket.create_connection((host, port), timeout=10)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    return sock
+
+
+def run(mode, host, port, auth, paths, count):
+    latencies = []
+    size = 0
+    sock = reader = None
+    start = time.monotonic()
+
+    n = 0
+    while n < count:
+        if not sock:
+            sock = connect(host, port)
+            reader = Reader(sock)
+        batch = paths if mode == "pipelined" else [paths[n % len(paths)]]
+        batch = batch[:count - n]
+        sent = time.monotonic()
+        sock.sendall(b"".join(request(path, host, auth, mode != "close") for path in batch))
+        for path in batch:
+            status, length, kept = reader.response()
+            if status == 429:
+                sys.exit("%s: rate limited after %d requests, see SERVER_RATE" % (mode, n))
+            if status != 200:
+                sys.exit("%s: %s answered %d" % (mode, path, status))
+            latencies.append(time.monotonic() - sent)
+            size += length
+            n += 1
+            if not kept:
+                break
+        if mode == "close" or not kept:
+            sock.close()
+            sock = None
+    if sock:
+        sock.close()
+
+    elapsed = time.monotonic() - start
+    latencies.sort()
+    print("%-10s %6d %8.1f %8.1f %8.1f %10.1f %10.1f" % (
+        mode, len(latencies),
+        statistics.median(latencies) * 1000,
+        latencies[int(len(latencies) * 0.95) - 1] * 1000,
+        latencies[-1] * 1000,
+        len(latencies) / elapsed,
+        size / elapsed / 1024))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="measure the web server of a lamp")
+    parser.add_argument("-u", "--user", help="<user>:<password> for the Basic Auth")
+    parser.add_argument("-n", "--requests", type=int, default=100, help="requests per mode")
+    parser.add_argument("-p", "--port", type=int, default=80)
+    parser.add_argument("host")
+    parser.add_argument("paths", nargs="*", default=PATHS)
+    args = parser.parse_args()
+
+    print("%-10s %6s %8s %8s %8s %10s %10s" % ("mode", "reqs", "p50[ms]", "p95[ms]", "max[ms]", "reqs/s", "KB/s"))
+    for mode in ("close", "keep-alive", "pipelined"):
+        run(mode, args.host, args.port, args.user, args.paths, args.requests)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,244 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the command line interface on the serial port
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "cli.h"
+#include "state.h"
+#include "util.h"
+
+#if FEATURE_CLI
+
+/*
+   the receiver states
+*/
+enum CLI_STATE {
+  CLI_STATE_LINE = 0,
+  CLI_STATE_FRAME_LEN,
+  CLI_STATE_FRAME_DATA,
+};
+
+/*
+   the CLI context
+*/
+static int _cli_state = CLI_STATE_LINE;
+static char _cli_line[CLI_LINE_MAX];
+static int _cli_line_len = 0;
+static byte *_cli_frame = NULL;
+static int _cli_frame_len = 0;
+static int _cli_frame_pos = 0;
+static unsigned long _cli_frame_start = 0;
+static unsigned long _cli_last_command = 0;
+
+/*
+   print a config field
+*/
+static void cli_print_field(const CONFIG_FIELD *field)
+{
+  char value[CLI_LINE_MAX];
+
+  if (!ConfigGetField(field, value, sizeof(value)))
+    return;
+  Serial.printf("%s=%s\n", field->name, (field->flags & CONFIG_FIELD_SECRET) ? "***" : value);
+}
+
+/*
+   the names of the field types as listed by the fields command
+*/
+static const char *cli_field_type(const CONFIG_FIELD *field)
+{
+  switch (field->type) {
+    case CONFIG_FIELD_STRING: return "string";
+    case CONFIG_FIELD_INT: return "int";
+  }
+  return "blob";
+}
+
+/*
+   execute the given command line
+*/
+static void cli_execute(char *line)
+{
+  char *save;
+  char *cmd = strtok_r(line, " \t\r", &save);
+  char *arg = strtok_r(NULL, " \t\r", &save);
+  const CONFIG_FIELD *field;
+
+  if (!cmd)
+    return;
+  _cli_last_command = millis();
+
+  if (!strcasecmp(cmd, "help")) {
+    Serial.print("OK commands: help, get [<name>], fields, set <name> <value>, save, restart\n");
+  }
+  else if (!strcasecmp(cmd, "fields")) {
+    for (int n = 0; n < ConfigFields(); n++) {
+      field = ConfigField(n);
+      Serial.printf("FIELD %s %d %s %d\n", field->name, field->tag, cli_field_type(field), field->size);
+    }
+    Serial.print("OK\n");
+  }
+  else if (!strcasecmp(cmd, "get")) {
+    if (!arg) {
+      for (int n = 0; n < ConfigFields(); n++)
+        cli_print_field(ConfigField(n));
+    }
+    else if (!(field = ConfigLookupField(arg))) {
+      Serial.printf("ERR unknown field %s\n", arg);
+      return;
+    }
+    else
+      cli_print_field(field);
+    Serial.print("OK\n");
+  }
+  else if (!strcasecmp(cmd, "set") && arg) {
+    char *value = strtok_r(NULL, "\r", &save);
+
+    if (!value)
+      value = (char *) "";
+    while (*value == ' ' || *value == '\t')
+      value++;
+    if (!(field = ConfigLookupField(arg)))
+      Serial.printf("ERR unknown field %s\n", arg);
+    else if (!ConfigSetField(field, value, strlen(value)))
+      Serial.printf("ERR field %s can't be set from text\n", arg);
+    else
+      Serial.print("OK\n");
+  }
+  else if (!strcasecmp(cmd, "save")) {
+    ConfigFlush();
+    Serial.print("OK\n");
+  }
+  else if (!strcasecmp(cmd, "restart")) {
+    Serial.print("OK\n");
+    StateChange(STATE_REBOOT);
+  }
+  else
+    Serial.printf("ERR unknown command %s\n", cmd);
+}
+
+/*
+   check and import the received frame
+*/
+static void cli_import_frame(void)
+{
+  uint32_t crc;
+
+  memcpy(&crc, _cli_frame + _cli_frame_len, sizeof(crc));
+  if (crc != Crc32(_cli_frame, _cli_frame_len))
+    Serial.print("ERR bad CRC\n");
+  else if (!ConfigImport(_cli_frame, _cli_frame_len))
+    Serial.print("ERR bad config\n");
+  else
+    Serial.print("OK\n");
+}
+
+/*
+   setup the command line interface
+*/
+void CliSetup(void)
+{
+  _cli_last_command = millis();
+  LogMsg("CLI: type help for a list of commands");
+}
+
+/*
+   cyclic update of the command line interface
+*/
+void CliUpdate(void)
+{
+  if (_cli_state != CLI_STATE_LINE && millis() - _cli_frame_start > CLI_FRAME_TIMEOUT) {
+    Serial.print("ERR frame timeout\n");
+    free(_cli_frame);
+    _cli_frame = NULL;
+    _cli_state = CLI_STATE_LINE;
+  }
+
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+
+    switch (_cli_state) {
+      case CLI_STATE_LINE:
+        if (c == CLI_FRAME_START && !_cli_line_len) {
+          /*
+             start of a binary frame
+          */
+          _cli_state = CLI_STATE_FRAME_LEN;
+          _cli_frame_start = _cli_last_command = millis();
+          _cli_frame_len = _cli_frame_pos = 0;
+        }
+        else if (c == '\n') {
+          _cli_line[_cli_line_len] = '\0';
+          _cli_line_len = 0;
+          cli_execute(_cli_line);
+        }
+        else if (_cli_line_len < (int) sizeof(_cli_line) - 1)
+          _cli_line[_cli_line_len++] = c;
+        break;
+      case CLI_STATE_FRAME_LEN:
+        _cli_frame_len |= c << (8 * _cli_frame_pos++);
+        if (_cli_frame_pos < 2)
+          break;
+        if (_cli_frame_len > CLI_FRAME_MAX || !(_cli_frame = (byte *) malloc(_cli_frame_len + sizeof(uint32_t)))) {
+          Serial.print("ERR frame too large\n");
+          _cli_state = CLI_STATE_LINE;
+          break;
+        }
+        _cli_frame_pos = 0;
+        _cli_state = CLI_STATE_FRAME_DATA;
+        break;
+      case CLI_STATE_FRAME_DATA:
+        _cli_frame[_cli_frame_pos++] = c;
+        if (_cli_frame_pos < _cli_frame_len + (int) sizeof(uint32_t)) {
+          if (!(_cli_frame_pos % CLI_FRAME_BLOCK)) {
+            /*
+               the block is taken, the sender may go on
+            */
+            _cli_frame_start = millis();
+            Serial.print("NEXT\n");
+          }
+          break;
+        }
+        cli_import_frame();
+        free(_cli_frame);
+        _cli_frame = NULL;
+        _cli_state = CLI_STATE_LINE;
+        break;
+    }
+  }
+}
+
+/*
+   return the time in seconds since the last command
+*/
+int CliLastCommand(void)
+{
+  return (millis() - _cli_last_command) / 1000;
+}
+
+#endif
+
+/**/
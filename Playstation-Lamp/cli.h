@@ -0,0 +1,96 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the command line interface on the serial port
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __CLI_H__
+#define __CLI_H__ 1
+
+#include "config.h"
+
+/*
+   max. length of a command line
+*/
+#define CLI_LINE_MAX        600
+
+/*
+   each block of a binary frame has to be received within this time [ms]
+*/
+#define CLI_FRAME_TIMEOUT   2000
+
+/*
+   a binary frame is taken in blocks of this size [bytes] -- the block has
+   to fit into the receive buffer of the serial port (256 bytes), which
+   has to hold it while the loop is busy, e.g. with a flash commit
+*/
+#define CLI_FRAME_BLOCK     128
+
+/*
+   the start and the max. length of a binary frame
+*/
+#define CLI_FRAME_START     0x02
+#define CLI_FRAME_MAX       4096
+
+/*
+   the command line interface
+
+   text commands are terminated by a newline:
+
+      help                      list the commands
+      get [<name>]              show the given or all config fields
+      fields                    list the config fields as FIELD <name> <tag> <type> <size>
+      set <name> <value>        set the config field
+      save                      commit pending changes to the flash
+      restart                   restart the device
+
+   a binary frame replaces the whole config in one transaction:
+
+      [0x02][len:16][config encoding:len][crc32:32]
+
+   the numbers are little endian, the CRC32 is computed over the config
+   encoding, which is the TLV encoding described in config.h -- after the
+   length, the encoding and the CRC are sent in blocks of CLI_FRAME_BLOCK
+   bytes, and each block but the last one is answered with NEXT, which
+   the sender has to wait for
+
+   each command is answered by a line starting with OK or ERR
+*/
+
+/*
+   setup the command line interface
+*/
+void CliSetup(void);
+
+/*
+   cyclic update of the command line interface
+*/
+void CliUpdate(void);
+
+/*
+   return the time in seconds since the last command
+*/
+int CliLastCommand(void);
+
+#endif
+
+/**/
@@ -24,38 +24,302 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "config.h"
-#include "eeprom.h"
+#include "journal.h"
+#include "event.h"
+#include "aoxa.h"
+#if FEATURE_MQTT
+#include "mqtt.h"
+#endif
+#if FEATURE_SCHEDULE
+#include "schedule.h"
+#endif
+#include "util.h"
 
 CONFIG _config;
 
+/*
+   the field descriptors -- the tag identifies the field in the flash, so
+   tags have to stay unique and must never be reused, even if the field
+   is dropped or stripped by a disabled feature
+*/
+#define CONFIG_FIELD_ENTRY(tag,type,name,ftype,flags,minimum,maximum) \
+  { #type "_" #name, tag, CONFIG_FIELD_ ## ftype, flags, offsetof(CONFIG, type.name), sizeof(((CONFIG *) 0)->type.name), minimum, maximum }
+
+static const CONFIG_FIELD _config_fields[] = {
+  CONFIG_FIELD_ENTRY(1, device, name, STRING, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(2, device, password, STRING, CONFIG_FIELD_SECRET, 0, 0),
+  CONFIG_FIELD_ENTRY(3, wifi, ssid, STRING, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(4, wifi, psk, STRING, CONFIG_FIELD_SECRET, 0, 0),
+#if FEATURE_NTP
+  CONFIG_FIELD_ENTRY(5, ntp, server, STRING, 0, 0, 0),
+#endif
+#if FEATURE_MQTT
+  CONFIG_FIELD_ENTRY(6, mqtt, server, STRING, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(7, mqtt, port, INT, 0, MQTT_PORT_MIN, MQTT_PORT_MAX),
+  CONFIG_FIELD_ENTRY(8, mqtt, user, STRING, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(9, mqtt, password, STRING, CONFIG_FIELD_SECRET, 0, 0),
+  CONFIG_FIELD_ENTRY(10, mqtt, clientID, STRING, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(11, mqtt, topicPrefix, STRING, 0, 0, 0),
+#endif
+  CONFIG_FIELD_ENTRY(12, aoxa, default_mode, INT, 0, AOXA_MODE_OFF, AOXA_MODE_LAST - 1),
+  CONFIG_FIELD_ENTRY(13, aoxa, fade_speed, INT, 0, AOXA_FADE_SPEED_MIN, AOXA_FADE_SPEED_MAX),
+  CONFIG_FIELD_ENTRY(14, aoxa, flash_speed, INT, 0, AOXA_FLASH_SPEED_MIN, AOXA_FLASH_SPEED_MAX),
+  CONFIG_FIELD_ENTRY(15, aoxa, blink_speed, INT, 0, AOXA_BLINK_SPEED_MIN, AOXA_BLINK_SPEED_MAX),
+  CONFIG_FIELD_ENTRY(16, aoxa, fire_speed, INT, 0, AOXA_FIRE_SPEED_MIN, AOXA_FIRE_SPEED_MAX),
+#if FEATURE_RULES
+  CONFIG_FIELD_ENTRY(17, rules, text, STRING, 0, 0, 0),
+#endif
+#if FEATURE_SCHEDULE
+  CONFIG_FIELD_ENTRY(18, schedule, entries, BLOB, 0, 0, 0),
+#endif
+  CONFIG_FIELD_ENTRY(19, presets, entries, BLOB, 0, 0, 0),
+  CONFIG_FIELD_ENTRY(20, aoxa, pins, STRING, 0, 0, 0),
+};
+
+#define CONFIG_FIELDS       (int) (sizeof(_config_fields) / sizeof(_config_fields[0]))
+#define CONFIG_FIELDS_ALL   (uint32_t) ((1ULL << CONFIG_FIELDS) - 1)
+#define CONFIG_TLV_HEADER   3
+
+static_assert(CONFIG_FIELDS <= 32, "the dirty fields are kept in a 32 bit mask");
+
+/*
+   the generation of the config -- it is odd while a writer updates the config,
+   so readers can detect and retry torn snapshots (seqlock)
+*/
+static volatile uint32_t _config_generation = 0;
+static portMUX_TYPE _config_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+   the fields which are not yet committed
+*/
+static uint32_t _config_dirty = 0;
+
+/*
+   the deferred commit
+*/
+static unsigned long _config_commit_due = 0;
+static unsigned long _config_commit_forced = 0;
+
+/*
+   flash wear statistics
+*/
+static unsigned long _config_commits = 0;
+static unsigned long _config_bytes_written = 0;
+
+/*
+   begin and end a write to the config
+*/
+static void config_write_begin(void)
+{
+  portENTER_CRITICAL(&_config_mux);
+  _config_generation++;
+  __sync_synchronize();
+}
+
+static void config_write_end(void)
+{
+  __sync_synchronize();
+  _config_generation++;
+  portEXIT_CRITICAL(&_config_mux);
+}
+
+/*
+   encode the fields of the given mask into the buffer
+
+   returns the length of the encoding
+*/
+static int config_encode(uint32_t mask, byte *buffer)
+{
+  byte *p = buffer;
+
+  for (int n = 0; n < CONFIG_FIELDS; n++) {
+    const CONFIG_FIELD *field = &_config_fields[n];
+    const byte *value = (const byte *) &_config + field->offset;
+    int len = field->size;
+
+    if (!(mask & (1UL << n)))
+      continue;
+    if (field->type == CONFIG_FIELD_STRING)
+      len = strnlen((const char *) value, field->size - 1);
+    *p++ = field->tag;
+    *p++ = len & 0xff;
+    *p++ = len >> 8;
+    memcpy(p, value, len);
+    p += len;
+  }
+  return p - buffer;
+}
+
+/*
+   lookup the field descriptor of the given tag
+*/
+static const CONFIG_FIELD *config_lookup_tag(int tag)
+{
+  for (int n = 0; n < CONFIG_FIELDS; n++)
+    if (_config_fields[n].tag == tag)
+      return &_config_fields[n];
+  return NULL;
+}
+
+/*
+   decode the given encoding into the given config
+
+   returns false if the encoding is malformed or holds unknown tags or
+   values of the wrong size -- the valid fields are decoded anyway, and
+   are marked in present if it is given
+*/
+static bool config_decode_into(const byte *data, int len, CONFIG *cfg, uint32_t *present = NULL)
+{
+  bool rc = true;
+
+  while (len >= CONFIG_TLV_HEADER) {
+    int tag = data[0];
+    int value_len = data[1] | (data[2] << 8);
+    const byte *value = data + CONFIG_TLV_HEADER;
+
+    if (CONFIG_TLV_HEADER + value_len > len)
+      return false;
+    data += CONFIG_TLV_HEADER + value_len;
+    len -= CONFIG_TLV_HEADER + value_len;
+
+    const CONFIG_FIELD *field = config_lookup_tag(tag);
+
+    if (!field) {
+      DbgMsg("CFG: skipping unknown tag %d", tag);
+      rc = false;
+      continue;
+    }
+
+    byte *target = (byte *) cfg + field->offset;
+
+    if (present)
+      *present |= 1UL << (field - _config_fields);
+    switch (field->type) {
+      case CONFIG_FIELD_STRING:
+        if (value_len >= field->size)
+          rc = false;
+        value_len = min(value_len, field->size - 1);
+        memcpy(target, value, value_len);
+        memset(target + value_len, 0, field->size - value_len);
+        break;
+      case CONFIG_FIELD_INT:
+      case CONFIG_FIELD_BLOB:
+        if (value_len == field->size)
+          memcpy(target, value, value_len);
+        else
+          rc = false;
+        break;
+    }
+  }
+  return rc && !len;
+}
+
+/*
+   check the given fields of the config with the bounds of the forms and
+   the JSON API -- the fields which are not set by text are checked as
+   their subsystems expect them, missing fields keep their defaults
+*/
+static bool config_check(const CONFIG *cfg, uint32_t present)
+{
+  int pins[AOXA_LEDS_MAX];
+
+  for (int n = 0; n < CONFIG_FIELDS; n++) {
+    const CONFIG_FIELD *field = &_config_fields[n];
+    int value;
+
+    if (field->type != CONFIG_FIELD_INT || !(present & (1UL << n)))
+      continue;
+    memcpy(&value, (const byte *) cfg + field->offset, sizeof(value));
+    if (value < field->minimum || value > field->maximum) {
+      LogMsg("CFG: %s is out of range", field->name);
+      return false;
+    }
+  }
+
+  if (cfg->aoxa.pins[0] && AoxaParsePins(cfg->aoxa.pins, pins) <= 0) {
+    LogMsg("CFG: aoxa_pins is invalid");
+    return false;
+  }
+
+#if FEATURE_SCHEDULE
+  for (unsigned int n = 0; n < SCHEDULE_ENTRIES; n++)
+    if (!ScheduleEntryValid(&cfg->schedule.entries[n])) {
+      LogMsg("CFG: schedule entry %d is invalid", n);
+      return false;
+    }
+#endif
+
+  for (int n = 0; n < AOXA_PRESETS; n++) {
+    const CONFIG_PRESET *preset = &cfg->presets.entries[n];
+
+    if (preset->used && (preset->mode < AOXA_MODE_FIRST || preset->mode > AOXA_MODE_LAST || preset->brightness > AOXA_BRIGHTNESS_MAX)) {
+      LogMsg("CFG: preset %d is invalid", n + 1);
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+   decode the given encoding into the config -- called on the replay of the journal
+*/
+static void config_decode(const byte *data, int len)
+{
+  config_decode_into(data, len, &_config);
+}
+
+/*
+   commit the pending changes
+*/
+static void config_commit(void)
+{
+  if (_config_dirty) {
+    /*
+       write the dirty fields as a delta -- if there is no room left,
+       the full config is written as a snapshot
+    */
+    byte *buffer = (byte *) malloc(CONFIG_FIELDS * CONFIG_TLV_HEADER + sizeof(CONFIG));
+    int len;
+
+    if (buffer) {
+      DbgMsg("CFG: committing dirty fields 0x%08x", _config_dirty);
+      len = config_encode(_config_dirty, buffer);
+      if (!JournalWrite(buffer, len)) {
+        len = config_encode(CONFIG_FIELDS_ALL, buffer);
+        if (!JournalCompact(buffer, len))
+          len = 0;
+      }
+      free(buffer);
+
+      if (len) {
+        _config_commits++;
+        _config_bytes_written += len;
+        LogMsg("CFG: committed changes to the flash (%lu commits, %lu bytes since boot)", _config_commits, _config_bytes_written);
+      }
+      else
+        LogMsg("CFG: committing changes to the flash failed");
+    }
+    _config_dirty = 0;
+  }
+  _config_commit_due = _config_commit_forced = 0;
+}
+
 /*
     setup the configuration
 */
 bool ConfigSetup(void)
 {
   int rc = true;
-  
-  /*
-     read the full config from the EEPROM
-  */
-  memset(&_config, 0, sizeof(CONFIG));
-  EepromInit(sizeof(CONFIG));
-  EepromRead(0, sizeof(CONFIG), &_config);
 
   /*
-     check if the config version is ok
+     recover the config from the journal
   */
-  if (strcmp(_config.magic, CONFIG_MAGIC) || _config.version != CONFIG_VERSION) {
-    /*
-       set a new default configuration
-    */
-    LogMsg("CFG: unexpected magic and version found -- erasing config and entering config mode");
-    memset(&_config, 0, sizeof(CONFIG));
-    
-    strcpy(_config.magic, CONFIG_MAGIC);
-    _config.version = CONFIG_VERSION;
+  memset(&_config, 0, sizeof(CONFIG));
+  if (!JournalSetup(config_decode)) {
+    LogMsg("CFG: no config found -- entering config mode");
     rc = false;
   }
 
@@ -70,36 +334,244 @@ bool ConfigSetup(void)
 */
 void ConfigUpdate(void)
 {
-  // nothing to do so far
+  unsigned long now = millis();
+
+  if (!_config_commit_due || (long) (now - _config_commit_due) < 0)
+    return;
+
+  /*
+     the changes settled -- commit them if the LEDs give us enough time
+  */
+  if (AoxaNextUpdate() >= CONFIG_COMMIT_WINDOW || (long) (now - _config_commit_forced) >= 0)
+    config_commit();
 }
 
 
 /*
    functions to get the configuration for a subsystem
 */
-void ConfigGet(int offset, int size, void *cfg)
+uint32_t ConfigGet(int offset, int size, void *cfg)
 {
+  uint32_t generation;
+
   DbgMsg("CFG: getting config: offset:%d  size:%d  cfg:%p", offset, size, cfg);
 
-  memcpy(cfg, (byte *) &_config + offset, size);
+  /*
+     copy until no writer interfered
+  */
+  do {
+    while ((generation = _config_generation) & 1)
+      ;
+    __sync_synchronize();
+    memcpy(cfg, (byte *) &_config + offset, size);
+    __sync_synchronize();
+  } while (generation != _config_generation);
 
 #if DBG_DUMP
   dump("CFG:", cfg, size);
 #endif
+  return generation;
+}
+
+/*
+   get the generation of the config -- it changes with every change of the config
+*/
+uint32_t ConfigGeneration(void)
+{
+  return _config_generation;
 }
 
 /*
-   functions to set the configuration for a subsystem -- will be written to the EEPROM
+   functions to set the configuration for a subsystem -- will be written to the journal
 */
 void ConfigSet(int offset, int size, void *cfg)
 {
-  DbgMsg("CFG: setting config: offset:%d  size:%d  cfg:%p", offset, size, cfg);
+  int changed = 0;
 
-  memcpy((byte *) &_config + offset, cfg, size);
+  DbgMsg("CFG: setting config: offset:%d  size:%d  cfg:%p", offset, size, cfg);
 
 #if DBG_DUMP
   dump("CFG:", cfg, size);
 #endif
 
-  EepromWrite(offset, size, (byte *) &_config + offset);
+  /*
+     only fields which differ are taken over and marked dirty
+  */
+  config_write_begin();
+  for (int n = 0; n < CONFIG_FIELDS; n++) {
+    const CONFIG_FIELD *field = &_config_fields[n];
+    int start = max(offset, (int) field->offset);
+    int end = min(offset + size, field->offset + field->size);
+
+    if (start >= end || !memcmp((byte *) &_config + start, (byte *) cfg + start - offset, end - start))
+      continue;
+    memmove((byte *) &_config + start, (byte *) cfg + start - offset, end - start);
+    _config_dirty |= 1UL << n;
+    changed++;
+  }
+  config_write_end();
+
+  if (!changed) {
+    DbgMsg("CFG: nothing changed");
+    return;
+  }
+
+  /*
+     defer the commit, so rapid changes get coalesced
+  */
+  _config_commit_due = millis() + CONFIG_COMMIT_DELAY;
+  if (!_config_commit_forced)
+    _config_commit_forced = millis() + CONFIG_COMMIT_MAX_DELAY;
+
+  EventPublish(EVENT_CONFIG, offset, size);
+}
+
+/*
+   commit pending changes immediately -- e.g. before a restart
+*/
+void ConfigFlush(void)
+{
+  config_commit();
+}
+
+/*
+   replace the whole config with the given encoding and commit it
+*/
+bool ConfigImport(const void *data, int len)
+{
+  CONFIG *cfg;
+  uint32_t present = 0;
+  bool rc;
+
+  if (!(cfg = (CONFIG *) calloc(1, sizeof(CONFIG))))
+    return false;
+  if ((rc = config_decode_into((const byte *) data, len, cfg, &present) && config_check(cfg, present))) {
+    LogMsg("CFG: importing config of %d bytes", len);
+    ConfigSet(0, sizeof(CONFIG), cfg);
+    ConfigFlush();
+  }
+  free(cfg);
+  return rc;
+}
+
+/*
+   erase the config in the RAM and in the flash
+*/
+void ConfigReset(void)
+{
+  LogMsg("CFG: resetting the config");
+  config_write_begin();
+  memset(&_config, 0, sizeof(CONFIG));
+  config_write_end();
+  _config_dirty = 0;
+  _config_commit_due = _config_commit_forced = 0;
+  JournalReset();
+  EventPublish(EVENT_CONFIG, 0, sizeof(CONFIG));
+}
+
+/*
+   get the number of fields and the field with the given index
+*/
+int ConfigFields(void)
+{
+  return CONFIG_FIELDS;
+}
+
+const CONFIG_FIELD *ConfigField(int n)
+{
+  return (n >= 0 && n < CONFIG_FIELDS) ? &_config_fields[n] : NULL;
+}
+
+/*
+   lookup the field with the given name
+*/
+const CONFIG_FIELD *ConfigLookupField(const char *name)
+{
+  for (int n = 0; n < CONFIG_FIELDS; n++)
+    if (!strcmp(name, _config_fields[n].name))
+      return &_config_fields[n];
+  return NULL;
+}
+
+/*
+   parse the text into the target of the field
+*/
+static bool config_parse(const CONFIG_FIELD *field, const char *value, int len, byte *target)
+{
+  char text[12];
+  int number;
+
+  switch (field->type) {
+    case CONFIG_FIELD_STRING:
+      len = min(len, field->size - 1);
+      memcpy(target, value, len);
+      memset(target + len, 0, field->size - len);
+      return true;
+    case CONFIG_FIELD_INT:
+      len = min(len, (int) sizeof(text) - 1);
+      memcpy(text, value, len);
+      text[len] = '\0';
+      number = min(max(atoi(text), (int) field->minimum), (int) field->maximum);
+      memcpy(target, &number, sizeof(number));
+      return true;
+  }
+  return false;
+}
+
+/*
+   parse the field from the given text into the given config
+*/
+bool ConfigParseField(const CONFIG_FIELD *field, const char *value, int len, CONFIG *cfg)
+{
+  return config_parse(field, value, len, (byte *) cfg + field->offset);
+}
+
+/*
+   set the field from the given text
+*/
+bool ConfigSetField(const CONFIG_FIELD *field, const char *value, int len)
+{
+  byte *target;
+  bool rc;
+
+  if (!(target = (byte *) malloc(field->size)))
+    return false;
+  if ((rc = config_parse(field, value, len, target)))
+    ConfigSet(field->offset, field->size, target);
+  free(target);
+  return rc;
+}
+
+/*
+   get the field as text into the given buffer
+*/
+bool ConfigGetField(const CONFIG_FIELD *field, char *buffer, int size)
+{
+  const byte *value = (const byte *) &_config + field->offset;
+
+  switch (field->type) {
+    case CONFIG_FIELD_STRING:
+      snprintf(buffer, size, "%s", (const char *) value);
+      return true;
+    case CONFIG_FIELD_INT:
+      snprintf(buffer, size, "%d", *(const int *) value);
+      return true;
+  }
+  return false;
+}
+
+/*
+   get the number of commits to the flash since boot
+*/
+unsigned long ConfigCommits(void)
+{
+  return _config_commits;
+}
+
+/*
+   get the number of bytes written since boot
+*/
+unsigned long ConfigBytesWritten(void)
+{
+  return _config_bytes_written;
 }/**/
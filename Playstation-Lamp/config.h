@@ -26,14 +26,49 @@
 #ifndef __CONFIG_H__
 #define __CONFIG_H__ 1
 
+#include <stdint.h>
 #include "aoxa.h"
 
 #include "git-version.h"
 
 /*
  * enable/disable features
+ *
+ * a disabled feature is stripped completely from the firmware, together
+ * with its config fields, its forms and its MQTT commands -- override them
+ * on the command line of the compiler, e.g. -DFEATURE_MQTT=0
  */
+#ifndef FEATURE_HTTP
+#define FEATURE_HTTP      1
+#endif
+#ifndef FEATURE_MQTT
+#define FEATURE_MQTT      1
+#endif
+#ifndef FEATURE_NTP
+#define FEATURE_NTP       1
+#endif
+#ifndef FEATURE_RULES
+#define FEATURE_RULES     1
+#endif
+#ifndef FEATURE_SCHEDULE
+#define FEATURE_SCHEDULE  1
+#endif
+#ifndef FEATURE_CLI
+#define FEATURE_CLI       1
+#endif
+#ifndef FEATURE_OTA
+#define FEATURE_OTA       1
+#endif
 
+#if FEATURE_SCHEDULE && !FEATURE_NTP
+#error "the schedule needs the time from NTP"
+#endif
+#if FEATURE_OTA && !FEATURE_HTTP
+#error "the firmware update needs HTTP"
+#endif
+#if !FEATURE_HTTP && !FEATURE_CLI
+#error "the device can't be configured without HTTP or the CLI"
+#endif
 
 #define __TITLE__   "Playstation-Lamp"
 
@@ -44,10 +79,26 @@
 #define DBG_DUMP    (DBG && 0)
 
 /*
-  tags to mark the configuration in the EEPROM
+   switch each LED on and off at startup -- this delays the boot
 */
-#define CONFIG_MAGIC      __TITLE__ "-CONFIG"
-#define CONFIG_VERSION    3
+#define AOXA_SELFTEST   (DBG && 0)
+
+/*
+   changes are committed to the flash this time [ms] after the last change,
+   so rapid changes are coalesced into one commit
+*/
+#define CONFIG_COMMIT_DELAY       2000
+
+/*
+   a commit stalls the CPU while the flash sector is erased and written,
+   so it is only done if the next LED update is at least this far away [ms]
+*/
+#define CONFIG_COMMIT_WINDOW      50
+
+/*
+   if no such window was found, the commit is forced after this time [ms]
+*/
+#define CONFIG_COMMIT_MAX_DELAY   10000
 
 /*
    sub-systems config structs
@@ -55,7 +106,6 @@
 typedef struct _config_device {
   char name[64];
   char password[64];
-  char reserved[256];
 } CONFIG_DEVICE;
 
 typedef struct _config_wifi {
@@ -74,7 +124,6 @@ typedef struct _config_mqtt {
   char password[64];
   char clientID[64];
   char topicPrefix[64];
-  char reserved[192];
 } CONFIG_MQTT;
 
 typedef struct _config_aoxa {
@@ -83,26 +132,102 @@ typedef struct _config_aoxa {
   int flash_speed;
   int blink_speed;
   int fire_speed;
+  char pins[64];    // comma separated GPIOs -- empty for AOXA_PINS_DEFAULT
 } CONFIG_AOXA;
 
+typedef struct _config_rules {
+  char text[512];
+} CONFIG_RULES;
+
+typedef struct _config_schedule_entry {
+  uint8_t days;     // bit 0 is sunday, bit 6 is saturday -- zero marks an unused entry
+  uint8_t hour;
+  uint8_t minute;
+  int8_t mode;
+} CONFIG_SCHEDULE_ENTRY;
+
+typedef struct _config_schedule {
+  CONFIG_SCHEDULE_ENTRY entries[16];
+} CONFIG_SCHEDULE;
+
+typedef struct _config_preset {
+  uint8_t used;
+  int8_t mode;
+  uint8_t brightness;
+  uint8_t reserved;
+  uint16_t fade_speed;    // a zero speed keeps the configured one
+  uint16_t flash_speed;
+  uint16_t blink_speed;
+  uint16_t fire_speed;
+} CONFIG_PRESET;
+
+typedef struct _config_presets {
+  CONFIG_PRESET entries[AOXA_PRESETS];
+} CONFIG_PRESETS;
+
 /*
-   the configuration layout
+   the configuration layout -- this is the layout in the RAM only,
+   see CONFIG_FIELD for the encoding in the flash
 */
 typedef struct _config {
-  char magic[sizeof(CONFIG_MAGIC) + 1];
-  int version;
   CONFIG_DEVICE device;
   CONFIG_WIFI wifi;
+#if FEATURE_NTP
   CONFIG_NTP ntp;
+#endif
+#if FEATURE_MQTT
   CONFIG_MQTT mqtt;
+#endif
   CONFIG_AOXA aoxa;
+#if FEATURE_RULES
+  CONFIG_RULES rules;
+#endif
+#if FEATURE_SCHEDULE
+  CONFIG_SCHEDULE schedule;
+#endif
+  CONFIG_PRESETS presets;
 } CONFIG;
 
 /*
    the config is global
+
+   NOTE: direct reads are only safe from the loop task, which is the only
+   writer -- other tasks have to take a snapshot with CONFIG_GET()
 */
 extern CONFIG _config;
 
+/*
+   the field descriptors
+
+   each field of the config is described by its name, as used by HTTP
+   and MQTT, its tag in the flash encoding, its type and its bounds
+
+   in the flash, the config is encoded as a sequence of
+
+      [tag:8][len:16][value:len]
+
+   strings are stored without padding, unknown tags are skipped and missing
+   tags keep their defaults -- so a tag must never be reused for another field
+*/
+enum CONFIG_FIELD_TYPE {
+  CONFIG_FIELD_STRING,
+  CONFIG_FIELD_INT,
+  CONFIG_FIELD_BLOB,
+};
+
+#define CONFIG_FIELD_SECRET   0x01    // the value is never reported (MQTT, JSON API, CLI)
+
+typedef struct _config_field {
+  const char *name;
+  uint8_t tag;
+  uint8_t type;
+  uint8_t flags;
+  uint16_t offset;
+  uint16_t size;
+  int32_t minimum;
+  int32_t maximum;
+} CONFIG_FIELD;
+
 /*
     setup the configuration
 */
@@ -115,14 +240,91 @@ void ConfigUpdate(void);
 
 /*
    functions to get the configuration for a subsystem
+
+   the copy is a consistent snapshot, even if the config is changed by
+   another task meanwhile -- the generation of the snapshot is returned
 */
 #define CONFIG_GET(type,name,cfg)  ConfigGet(offsetof(CONFIG,name),sizeof(CONFIG_ ## type),(void *) (cfg))
-void ConfigGet(int offset, int size, void *cfg);
+uint32_t ConfigGet(int offset, int size, void *cfg);
+
+/*
+   check if the given range of a config change covers the config of a subsystem
+*/
+#define CONFIG_COVERS(offset,size,type,name)  ((offset) < (int) (offsetof(CONFIG,name) + sizeof(CONFIG_ ## type)) && (offset) + (size) > (int) offsetof(CONFIG,name))
+
+/*
+   get the generation of the config -- it changes with every change of the
+   config, so cached snapshots can be checked cheaply
+*/
+uint32_t ConfigGeneration(void);
 
 /*
-   functions to set the configuration for a subsystem -- will be written to the EEPROM
+   functions to set the configuration for a subsystem -- will be written to the journal
+
+   the write is deferred, see CONFIG_COMMIT_DELAY
 */
 #define CONFIG_SET(type,name,cfg)  ConfigSet(offsetof(CONFIG,name),sizeof(type),(void *) (cfg))
 void ConfigSet(int offset, int size, void *cfg);
 
+/*
+   commit pending changes immediately -- e.g. before a restart
+*/
+void ConfigFlush(void);
+
+/*
+   replace the whole config with the given encoding and commit it
+
+   returns false and leaves the config untouched if the encoding is not valid,
+   or a value is out of the bounds the forms and the JSON API enforce
+*/
+bool ConfigImport(const void *data, int len);
+
+/*
+   erase the config in the RAM and in the flash
+*/
+void ConfigReset(void);
+
+/*
+   get the number of fields and the field with the given index
+*/
+int ConfigFields(void);
+const CONFIG_FIELD *ConfigField(int n);
+
+/*
+   lookup the field with the given name
+
+   returns NULL if there is no such field
+*/
+const CONFIG_FIELD *ConfigLookupField(const char *name);
+
+/*
+   parse the field from the given text into the given config -- numbers are
+   clipped to the bounds
+
+   returns false if the field can't be set from a text
+*/
+bool ConfigParseField(const CONFIG_FIELD *field, const char *value, int len, CONFIG *cfg);
+
+/*
+   set the field from the given text -- see ConfigParseField()
+*/
+bool ConfigSetField(const CONFIG_FIELD *field, const char *value, int len);
+
+/*
+   get the field as text into the given buffer
+
+   returns false if the field can't be represented as text
+*/
+bool ConfigGetField(const CONFIG_FIELD *field, char *buffer, int size);
+
+/*
+   get the number of commits to the flash since boot
+*/
+unsigned long ConfigCommits(void);
+
+/*
+   get the number of bytes written since boot
+*/
+unsigned long ConfigBytesWritten(void);
+
 #endif
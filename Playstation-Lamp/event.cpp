@@ -0,0 +1,194 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the internal event bus
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include "config.h"
+#include "event.h"
+#include "util.h"
+
+/*
+   a subscriber with its own queue
+*/
+typedef struct {
+  const char *name;
+  unsigned long mask;
+  EVENT_HANDLER handler;
+  EVENT queue[EVENT_QUEUE_LEN];
+  volatile uint8_t head;   // next slot to write
+  volatile uint8_t tail;   // next slot to read
+} EVENT_SUBSCRIBER;
+
+/*
+   the static subscriber table
+*/
+static EVENT_SUBSCRIBER _event_subscribers[EVENT_SUBSCRIBERS_MAX];
+static int _event_subscriber_count = 0;
+
+/*
+   some statistics
+*/
+static unsigned long _event_count[EVENT_TYPES];
+static unsigned long _event_dropped = 0;
+
+/*
+   protect the queues, as events might be published from other tasks
+*/
+static portMUX_TYPE _event_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+   the logging subscriber
+*/
+static void event_log_handler(const EVENT *event)
+{
+  DbgMsg("EVENT: %s  arg:%d  arg2:%d  age:%lums", EventLookupType(event->type), event->arg, event->arg2, millis() - event->time);
+}
+
+/*
+   setup the event bus
+*/
+void EventSetup(void)
+{
+  LogMsg("EVENT: setting up event bus");
+
+  EventSubscribe("log", EVENT_MASK_ALL, event_log_handler);
+}
+
+/*
+   cyclic update of the event bus -- deliver the queued events
+
+   each subscriber gets only a limited number of events per cycle,
+   so a burst of events can't stall the main loop
+*/
+void EventUpdate(void)
+{
+  for (int n = 0; n < _event_subscriber_count; n++) {
+    EVENT_SUBSCRIBER *sub = &_event_subscribers[n];
+
+    for (int count = 0; count < EVENT_DISPATCH_MAX && sub->tail != sub->head; count++) {
+      EVENT event = sub->queue[sub->tail];
+
+      sub->tail = (sub->tail + 1) % EVENT_QUEUE_LEN;
+      sub->handler(&event);
+    }
+  }
+}
+
+/*
+   subscribe to the event types given in the mask
+
+   returns false if the subscriber table is full
+*/
+bool EventSubscribe(const char *name, unsigned long mask, EVENT_HANDLER handler)
+{
+  if (_event_subscriber_count >= EVENT_SUBSCRIBERS_MAX) {
+    LogMsg("EVENT: subscriber table full -- can't subscribe %s", name);
+    return false;
+  }
+
+  EVENT_SUBSCRIBER *sub = &_event_subscribers[_event_subscriber_count];
+
+  sub->name = name;
+  sub->mask = mask;
+  sub->handler = handler;
+  sub->head = sub->tail = 0;
+  _event_subscriber_count++;
+
+  DbgMsg("EVENT: subscribed %s with mask 0x%08lx", name, mask);
+  return true;
+}
+
+/*
+   publish an event to all subscribers
+
+   the event is only copied into the queues of the subscribers,
+   the delivery is done in EventUpdate()
+*/
+void EventPublish(int type, int arg, int arg2)
+{
+  EVENT event;
+
+  if (type <= EVENT_NONE || type >= EVENT_TYPES)
+    return;
+
+  event.type = type;
+  event.arg = arg;
+  event.arg2 = arg2;
+  event.time = millis();
+
+  portENTER_CRITICAL(&_event_mux);
+  _event_count[type]++;
+  for (int n = 0; n < _event_subscriber_count; n++) {
+    EVENT_SUBSCRIBER *sub = &_event_subscribers[n];
+
+    if (!(sub->mask & EVENT_MASK(type)))
+      continue;
+
+    uint8_t next = (sub->head + 1) % EVENT_QUEUE_LEN;
+
+    if (next == sub->tail) {
+      /*
+         this subscriber is too slow -- drop the event
+      */
+      _event_dropped++;
+      continue;
+    }
+    sub->queue[sub->head] = event;
+    sub->head = next;
+  }
+  portEXIT_CRITICAL(&_event_mux);
+}
+
+/*
+   lookup the name of the given event type
+*/
+const char *EventLookupType(int type)
+{
+#define EVENT_TYPE_CASE(type) case EVENT_ ## type: return #type; break;
+  switch (type) {
+      EVENT_TYPE_CASE(NONE);
+      EVENT_TYPE_CASE(AOXA_MODE);
+      EVENT_TYPE_CASE(AOXA_BUTTON);
+      EVENT_TYPE_CASE(AOXA_BRIGHTNESS);
+      EVENT_TYPE_CASE(WIFI);
+      EVENT_TYPE_CASE(MQTT);
+      EVENT_TYPE_CASE(CONFIG);
+  }
+  return NULL;
+}
+
+/*
+   get the number of events published for the given type
+*/
+unsigned long EventCount(int type)
+{
+  return (type > EVENT_NONE && type < EVENT_TYPES) ? _event_count[type] : 0;
+}
+
+/*
+   get the number of events dropped because of full subscriber queues
+*/
+unsigned long EventDropped(void)
+{
+  return _event_dropped;
+}/**/
@@ -0,0 +1,124 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the internal event bus
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __EVENT_H__
+#define __EVENT_H__ 1
+
+#include <Arduino.h>
+#include "config.h"
+
+/*
+   max. number of subscribers in the static subscriber table
+*/
+#define EVENT_SUBSCRIBERS_MAX   10
+
+/*
+   number of events each subscriber can have pending
+
+   if a subscriber is too slow, further events for it are dropped
+   and counted -- the producer is never blocked
+*/
+#define EVENT_QUEUE_LEN         8
+
+/*
+   max. number of events delivered to one subscriber per update cycle
+*/
+#define EVENT_DISPATCH_MAX      4
+
+/*
+   the event types
+*/
+enum EVENT_TYPE {
+  EVENT_NONE = 0,
+  EVENT_AOXA_MODE,        // arg: the new AOXA mode
+  EVENT_AOXA_BUTTON,      // arg: AOXA_BUTTON_PRESS or AOXA_BUTTON_LONG_PRESS
+  EVENT_AOXA_BRIGHTNESS,  // arg: the new brightness in percent
+  EVENT_WIFI,             // arg: true if connected, false if the connection was lost
+  EVENT_MQTT,             // arg: true if connected, false if the connection was lost
+  EVENT_CONFIG,           // arg: offset of the changed config area, arg2: its size
+  EVENT_TYPES,            // helper
+};
+
+/*
+   build the subscription mask for an event type
+*/
+#define EVENT_MASK(type)    (1UL << (type))
+#define EVENT_MASK_ALL      (~0UL)
+
+/*
+   an event -- passed by value
+*/
+typedef struct {
+  uint8_t type;
+  int arg;
+  int arg2;
+  unsigned long time;
+} EVENT;
+
+/*
+   the event handler of a subscriber
+*/
+typedef void (*EVENT_HANDLER)(const EVENT *event);
+
+/*
+   setup the event bus
+*/
+void EventSetup(void);
+
+/*
+   cyclic update of the event bus -- deliver the queued events
+*/
+void EventUpdate(void);
+
+/*
+   subscribe to the event types given in the mask
+
+   returns false if the subscriber table is full
+*/
+bool EventSubscribe(const char *name, unsigned long mask, EVENT_HANDLER handler);
+
+/*
+   publish an event to all subscribers
+*/
+void EventPublish(int type, int arg = 0, int arg2 = 0);
+
+/*
+   lookup the name of the given event type
+*/
+const char *EventLookupType(int type);
+
+/*
+   get the number of events published for the given type
+*/
+unsigned long EventCount(int type);
+
+/*
+   get the number of events dropped because of full subscriber queues
+*/
+unsigned long EventDropped(void);
+
+#endif
+
+/**/
@@ -24,484 +24,784 @@
 
 */
 
-#include <WebServer.h>
 #include "config.h"
 #include "http.h"
+#include "server.h"
+#include "api.h"
+#include "sse.h"
+#if FEATURE_OTA
+#include "ota.h"
+#endif
 #include "wifi.h"
+#if FEATURE_MQTT
 #include "mqtt.h"
+#endif
+#if FEATURE_NTP
 #include "ntp.h"
+#endif
 #include "led.h"
 #include "aoxa.h"
+#include "event.h"
+#include "journal.h"
+#include "writer.h"
+#include "assets.h"
+#if FEATURE_RULES
+#include "rules.h"
+#endif
+#if FEATURE_SCHEDULE
+#include "schedule.h"
+#endif
+
+#if FEATURE_HTTP
 
 /*
-   the web server object
+   the static parts of the pages
 */
-static WebServer _WebServer(80);
+#define HTTP_HTML_HEADER \
+  "<!DOCTYPE html>" \
+  "<html>" \
+  "<head>" \
+  "<meta charset='utf-8'>" \
+  "<meta name='viewport' content='width=device-width,initial-scale=1,user-scalable=no'>" \
+  "<title>" __TITLE__ "</title>" \
+  "<link href='/styles.css?" ASSET_STYLES_CSS_HASH "' rel='stylesheet' type='text/css'>" \
+  "</head>" \
+  "<body>" \
+  "<div class=content>" \
+  "<div class=header>" \
+  "<h3>" __TITLE__ "</h3>" \
+  "<h2>"
+
+#define HTTP_HTML_FOOTER \
+  "<div class=footer>" \
+  "<hr>" \
+  "<a href='https://github.com/gromeck/Playstation-Lamp' target='_blank' style='color:#aaa;'>" __TITLE__ " Version: " GIT_VERSION "</a>" \
+  "</div>" \
+  "</div>" \
+  "</body>" \
+  "</html>"
+
+#define HTTP_MAIN_MENU    "<p><form action='/' method='get'><button>Main Menu</button></form><p>"
+#define HTTP_CONFIG_MENU  "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
 
 /*
-  time of the last HTTP request
+   the assets are referenced with their hash in the URL, so a new
+   version gets a new URL and they can be cached forever
 */
-static unsigned long _last_request = 0;
+#define HTTP_ASSET_CACHE_CONTROL  "public, max-age=31536000, immutable"
 
 /*
-   setup the webserver
+   send a static asset -- it is sent compressed, or not at all if the
+   client has it already
 */
-void HttpSetup(void)
+static void http_asset(SERVER_REQUEST *request, WRITER *w, const ASSET *asset)
 {
-  static String _html_header =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<meta charset='utf-8'>"
-    "<meta name='viewport' content='width=device-width,initial-scale=1,user-scalable=no'>"
-    "<title>" __TITLE__ "</title>"
-    "<link href='/styles.css' rel='stylesheet' type='text/css'>"
-    "</head>"
-    "<body>"
-    "<div class=content>"
-    "<div class=header>"
-    "<h3>" __TITLE__ "</h3>"
-    "<h2>" + String(_config.device.name) + "</h2>"
-    "</div>"
-    ;
-  static String _html_footer =
-    "<div class=footer>"
-    "<hr>"
-    "<a href='https://github.com/gromeck/Playstation-Lamp' target='_blank' style='color:#aaa;'>" __TITLE__ " Version: " GIT_VERSION "</a>"
-    "</div>"
-    "</div>"
-    "</body>"
-    "</html>"
-    ;
+  bool cached = request->if_none_match && !strcmp(request->if_none_match, asset->etag);
+
+  WriterBegin(w, request->client, cached ? 304 : 200, cached ? NULL : asset->type);
+  WriterHeader(w, "ETag", asset->etag);
+  WriterHeader(w, "Cache-Control", HTTP_ASSET_CACHE_CONTROL);
+  if (cached)
+    WriterBody(w, WRITER_NO_BODY);
+  else {
+    WriterHeader(w, "Content-Encoding", "gzip");
+    WriterBody(w, asset->len);
+    WriterWrite(w, asset->data, asset->len);
+  }
+  WriterEnd(w);
+}
 
-  LogMsg("HTTP: setting up HTTP server");
+/*
+   the cache of rendered pages and parts of pages -- an entry is valid as
+   long as neither the config nor the connectivity changed since it was
+   rendered, so a repeated request is answered from it
+*/
+typedef struct _http_cache_entry {
+  const char *key;                // NULL if the entry is unused
+  uint32_t config_generation;
+  uint32_t generation;
+  unsigned long used;
+  int len;
+  char data[HTTP_CACHE_SIZE];
+} HTTP_CACHE_ENTRY;
+
+static HTTP_CACHE_ENTRY _http_cache[HTTP_CACHE_ENTRIES];
+static HTTP_CACHE_ENTRY *_http_cache_capture = NULL;
+static const char *_http_cache_key = NULL;
+static uint32_t _http_cache_generation = 0;
+static unsigned long _http_cache_hits = 0;
+static unsigned long _http_cache_misses = 0;
+
+/*
+   the pages show the state of the connections and what the subsystems
+   derived from the config when they got the change
+*/
+static void http_event_handler(const EVENT *event)
+{
+  _http_cache_generation++;
+}
 
+/*
+   get the valid cache entry of the given key
+*/
+static HTTP_CACHE_ENTRY *http_cache_lookup(const char *key)
+{
   /*
-     get the current config as a duplicate
+     in the access point mode the pages differ and are rarely requested
   */
-  ConfigGet(0, sizeof(CONFIG), &_config);
-
-  _WebServer.onNotFound( []() {
-    _last_request = millis();
-    if (!StateCheck(STATE_CONFIGURING) && _config.device.password[0] && !_WebServer.authenticate(HTTP_WEB_USER, _config.device.password))
-      return _WebServer.requestAuthentication();
-      
-    if (_WebServer.hasArg("switch"))
-      AoxaNextMode();
-
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<p><form action='/' method='get'><button name='switch' type='submit' class='button switch'>" + AoxaLookupMode(AoxaGetMode()) + "</button></form><p>"
-                    "<form action='/config' method='get'><button>Configuration</button></form><p>"
-                    "<form action='/info' method='get'><button>Information</button></form><p>"
-                    "<form action='/restart' method='get' onsubmit=\"return confirm('Are you sure to restart the device?');\"><button class='button redbg'>Restart</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/styles.css", []() {
-    _last_request = millis();
-    _WebServer.send(200, "text/css",
-                    "html, body { background:#ffffff; }"
-                    "body { margin:1rem; padding:0; font-familiy:'sans-serif'; color:#202020; text-align:center; font-size:1rem; }"
-                    "input { width:90%; font-size:1rem; }"
-                    "button { border:0; border-radius:0.3rem; background:#1881ba; color:#ffffff; line-height:2.4rem; font-size:1.2rem; width:100%; -webkit-transition-duration:0.5s; transition-duration:0.5s; cursor:pointer; opacity:0.8; }"
-                    "button:hover { opacity:1.0; }"
-                    ".switch { padding:2rem; background:#f0f0f0; color:#202020; text-align:center; font-weight: bold; font-size: 3rem; }"
-                    ".header { text-align:center; }"
-                    ".content { text-align:left; display:inline-block; color:#000000; min-width:340px; }"
-                    ".msg { text-align:center; color:#be3731; font-weight:bold; padding:5rem 0; }"
-                    ".footer { text-align:right; }"
-                    ".greenbg { background:#348f4b; }"
-                    ".redbg { background:#a12828; }"
-                   );
-  });
-
-  _WebServer.on("/config", []() {
-    _last_request = millis();
-    if (!StateCheck(STATE_CONFIGURING) && _config.device.password[0] && !_WebServer.authenticate(HTTP_WEB_USER, _config.device.password))
-      return _WebServer.requestAuthentication();
+  if (StateCheck(STATE_CONFIGURING))
+    return NULL;
 
-    /*
-       handle configuration changes
-    */
-#if DBG
-    for (int n = 0; n < _WebServer.args(); n++ )
-      LogMsg("HTTP: args: %s=%s", _WebServer.argName(n).c_str(), _WebServer.arg(n).c_str());
-#endif
+  for (int n = 0; n < HTTP_CACHE_ENTRIES; n++) {
+    HTTP_CACHE_ENTRY *entry = &_http_cache[n];
+
+    if (entry->key == key) {
+      if (entry->config_generation != ConfigGeneration() || entry->generation != _http_cache_generation)
+        return NULL;
+      entry->used = millis();
+      return entry;
+    }
+  }
+  return NULL;
+}
 
-    if (_WebServer.hasArg("save")) {
-      /*
-         take over the configuration parameters
-      */
-#define CHECK_AND_SET_STRING(type,name) { if (_WebServer.hasArg(#type "_" #name)) strncpy(_config.type.name,_WebServer.arg(#type "_" #name).c_str(),sizeof(_config.type.name) - 1); }
-#define CHECK_AND_SET_NUMBER(type,name,minimum,maximum) { if (_WebServer.hasArg(#type "_" #name)) _config.type.name = min(max(atoi(_WebServer.arg(#type "_" #name).c_str()),(int) (minimum)),(int) (maximum)); }
-      CHECK_AND_SET_STRING(device, name);
-      CHECK_AND_SET_STRING(device, password);
-      CHECK_AND_SET_STRING(wifi, ssid);
-      CHECK_AND_SET_STRING(wifi, psk);
-      CHECK_AND_SET_STRING(ntp, server);
-      CHECK_AND_SET_STRING(mqtt, server);
-      CHECK_AND_SET_NUMBER(mqtt, port, MQTT_PORT_MIN, MQTT_PORT_MAX);
-      CHECK_AND_SET_STRING(mqtt, user);
-      CHECK_AND_SET_STRING(mqtt, password);
-      CHECK_AND_SET_STRING(mqtt, clientID);
-      CHECK_AND_SET_STRING(mqtt, topicPrefix);
-      CHECK_AND_SET_NUMBER(aoxa, default_mode, AOXA_MODE_OFF, AOXA_MODE_LAST - 1);
-      CHECK_AND_SET_NUMBER(aoxa, fade_speed, AOXA_FADE_SPEED_MIN, AOXA_FADE_SPEED_MAX);
-      CHECK_AND_SET_NUMBER(aoxa, flash_speed, AOXA_FLASH_SPEED_MIN, AOXA_FLASH_SPEED_MAX);
-      CHECK_AND_SET_NUMBER(aoxa, blink_speed, AOXA_BLINK_SPEED_MIN, AOXA_BLINK_SPEED_MAX);
-      CHECK_AND_SET_NUMBER(aoxa, fire_speed, AOXA_FIRE_SPEED_MIN, AOXA_FIRE_SPEED_MAX);
-
-      /*
-         write the config back
-      */
-      ConfigSet(0, sizeof(CONFIG), &_config);
+/*
+   start to cache what is written from now on under the given key -- the
+   entry of the key is reused, otherwise the least recently used one
+*/
+static void http_cache_begin(WRITER *w, const char *key)
+{
+  HTTP_CACHE_ENTRY *entry = &_http_cache[0];
+  unsigned long now = millis();
+
+  _http_cache_misses++;
+  if (StateCheck(STATE_CONFIGURING))
+    return;
+
+  for (int n = 0; n < HTTP_CACHE_ENTRIES; n++) {
+    if (_http_cache[n].key == key) {
+      entry = &_http_cache[n];
+      break;
     }
+    if (!_http_cache[n].key || now - _http_cache[n].used > now - entry->used)
+      entry = &_http_cache[n];
+  }
 
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form action='/config/device' method='get'><button>Configure Device</button></form><p>"
-                    "<form action='/config/wifi' method='get'><button>Configure WiFi</button></form><p>"
-                    "<form action='/config/ntp' method='get'><button>Configure NTP</button></form><p>"
-                    "<form action='/config/mqtt' method='get'><button>Configure MQTT</button></form><p>"
-                    "<form action='/config/leds' method='get'><button>Configure LEDs</button></form><p>"
-                    "<form action='/config/reset' method='get' onsubmit=\"return confirm('Are you sure to reset the configuration?');\"><button class='button redbg'>Reset configuration</button></form><p>"
-                    "<p><form action='/' method='get'><button>Main Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/config/device", []() {
-    _last_request = millis();
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form method='get' action='/config'>"
-
-                    "<fieldset>"
-                    "<legend>"
-                    "<b>&nbsp;Device&nbsp;</b>"
-                    "</legend>"
-
-                    "<b>Name</b>"
-                    "<br>"
-                    "<input name='device_name' type='text' placeholder='Device name' value='" + String(_config.device.name) + "'>"
-                    "<p>"
-
-                    "<b>Web Password</b>"
-                    "<br>"
-                    "<input name='device_password' type='password' placeholder='Device Password' value='" + String(_config.device.password) + "'>"
-                    "<p>"
-
-                    "<b>Note:</b> username for authentication is <b>" HTTP_WEB_USER "</b>"
-                    "<p>"
-                    "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
-                    "</fieldset>"
-                    "</form>"
-                    "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/config/wifi", []() {
-    _last_request = millis();
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form method='get' action='/config'>"
-                    "<fieldset>"
-                    "<legend>"
-                    "<b>&nbsp;WiFi&nbsp;</b>"
-                    "</legend>"
-
-                    "<b>SSID</b>"
-                    "<br>"
-                    "<input name='wifi_ssid' type='text' placeholder='WiFi SSID' value='" + String(_config.wifi.ssid) + "'>"
-                    "<p>"
-
-                    "<b>Password</b>"
-                    "<br>"
-                    "<input name='wifi_psk' type='password' placeholder='WiFi Password' value='" + String(_config.wifi.psk) + "'>"
-                    "<p>"
-
-                    "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
-                    "</fieldset>"
-                    "</form>"
-                    "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/config/ntp", []() {
-    _last_request = millis();
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form method='get' action='/config'>"
-                    "<fieldset>"
-                    "<legend>"
-                    "<b>&nbsp;NTP&nbsp;</b>"
-                    "</legend>"
-
-                    "<b>Server</b>"
-                    "<br>"
-                    "<input name='ntp_server' type='text' placeholder='NTP server' value='" + String(_config.ntp.server) + "'>"
-                    "<p>"
-
-                    "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
-                    "</fieldset>"
-                    "</form>"
-                    "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/config/mqtt", []() {
-    _last_request = millis();
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form method='get' action='/config'>"
-                    "<fieldset>"
-                    "<legend>"
-                    "<b>&nbsp;MQTT&nbsp;</b>"
-                    "</legend>"
-
-                    "<b>Server</b>"
-                    "<br>"
-                    "<input name='mqtt_server' type='text' placeholder='MQTT server' value='" + String(_config.mqtt.server) + "'>"
-                    "<p>"
-
-                    "<b>Port</b>"
-                    "<br>"
-                    "<input name='mqtt_port' type='text' placeholder='MQTT port' value='" + String(_config.mqtt.port) + "'>"
-                    "<p>"
-
-                    "<b>User (optional)</b>"
-                    "<br>"
-                    "<input name='mqtt_user' type='text' placeholder='MQTT user' value='" + String(_config.mqtt.user) + "'>"
-                    "<p>"
-
-                    "<b>Password (optional)</b>"
-                    "<br>"
-                    "<input name='mqtt_password' type='text' placeholder='MQTT password' value='" + String(_config.mqtt.password) + "'>"
-                    "<p>"
-
-                    "<b>ClientID</b>"
-                    "<br>"
-                    "<input name='mqtt_clientID' type='text' placeholder='MQTT ClientID' value='" + String(_config.mqtt.clientID) + "'>"
-                    "<p>"
-
-                    "<b>TopicPrefix</b>"
-                    "<br>"
-                    "<input name='mqtt_topicPrefix' type='text' placeholder='MQTT Topic Prefix' value='" + String(_config.mqtt.topicPrefix) + "'>"
-                    "<p>"
-
-                    "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
-                    "</fieldset>"
-                    "</form>"
-                    "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/config/leds", []() {
-    _last_request = millis();
-
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<form method='get' action='/config'>"
-
-                    "<fieldset>"
-                    "<legend>"
-                    "<b>&nbsp;LEDs&nbsp;</b>"
-                    "</legend>"
-
-                    "<b>Startup Mode</b> "
-                    "<br>"
-                    "<input name='aoxa_default_mode' type='number' placeholder='Startup Mode' min=" + String(AOXA_MODE_OFF) + " max=" + String(AOXA_MODE_LAST - 1) + " value='" + String(_config.aoxa.default_mode) + "'>"
-                    "<p>"
-
-                    "<b>Fade Speed [ms]</b> "
-                    "<br>"
-                    "<input name='aoxa_fade_speed' type='number' placeholder='LED Fade Speed' min=" + String(AOXA_FADE_SPEED_MIN) + " max=" + String(AOXA_FADE_SPEED_MAX) + " value='" + String(_config.aoxa.fade_speed) + "'>"
-                    "<p>"
-
-                    "<b>Flash Speed [ms]</b> "
-                    "<br>"
-                    "<input name='aoxa_flash_speed' type='number' placeholder='LED Flash Speed' min=" + String(AOXA_FLASH_SPEED_MIN) + " max=" + String(AOXA_FLASH_SPEED_MAX) + " value='" + String(_config.aoxa.flash_speed) + "'>"
-                    "<p>"
-
-                    "<b>Blink Speed [ms]</b> "
-                    "<br>"
-                    "<input name='aoxa_blink_speed' type='number' placeholder='LED Blink Speed' min=" + String(AOXA_BLINK_SPEED_MIN) + " max=" + String(AOXA_BLINK_SPEED_MAX) + " value='" + String(_config.aoxa.blink_speed) + "'>"
-                    "<p>"
-
-                    "<b>Fire Speed [ms]</b> "
-                    "<br>"
-                    "<input name='aoxa_fire_speed' type='number' placeholder='LED Fire Speed' min=" + String(AOXA_FIRE_SPEED_MIN) + " max=" + String(AOXA_FIRE_SPEED_MAX) + " value='" + String(_config.aoxa.fire_speed) + "'>"
-                    "<p>"
-
-                    "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
-                    "</fieldset>"
-                    "</form>"
-                    "<p><form action='/config' method='get'><button>Configuration Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-
-  _WebServer.on("/config/reset", []() {
-    _last_request = millis();
-    if (!StateCheck(STATE_CONFIGURING) && _config.device.password[0] && !_WebServer.authenticate(HTTP_WEB_USER, _config.device.password))
-      return _WebServer.requestAuthentication();
+  /*
+     the entry gets its key once it is complete
+  */
+  entry->key = NULL;
+  entry->config_generation = ConfigGeneration();
+  entry->generation = _http_cache_generation;
+  entry->used = now;
+  _http_cache_capture = entry;
+  _http_cache_key = key;
+  WriterCapture(w, entry->data, sizeof(entry->data));
+}
 
-    /*
-       reset the config
-    */
-    memset(&_config, 0, sizeof(_config));
-    ConfigSet(0, sizeof(CONFIG), &_config);
-
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<div class='msg'>"
-                    "Configuration was reset."
-                    "<p>"
-                    "Wait for the device to come up with an WiFi-AccessPoint, connect to it to configure the device."
-                    "</div>"
-                    + _html_footer);
+/*
+   store what was written since http_cache_begin() -- it is dropped if it
+   didn't fit
+*/
+static void http_cache_end(WRITER *w)
+{
+  HTTP_CACHE_ENTRY *entry = _http_cache_capture;
+  int len = WriterCapture(w, NULL, 0);
+
+  _http_cache_capture = NULL;
+  if (!entry)
+    return;
+  if (len < 0) {
+    DbgMsg("HTTP: %s doesn't fit into the cache", _http_cache_key);
+    return;
+  }
+  entry->key = _http_cache_key;
+  entry->len = len;
+}
+
+/*
+   write a part of a page from the cache, or start to cache it
+
+   returns true if it was written from the cache, otherwise it has to be
+   written and http_cache_end() called
+*/
+static bool http_cached(WRITER *w, const char *key)
+{
+  HTTP_CACHE_ENTRY *entry = http_cache_lookup(key);
+
+  if (entry) {
+    _http_cache_hits++;
+    WriterWrite(w, entry->data, entry->len);
+    return true;
+  }
+  http_cache_begin(w, key);
+  return false;
+}
+
+/*
+   start a page -- the response is chunked, so its length needn't be known
+
+   with a key the whole page is cached until http_page_end() -- if it is in
+   the cache already, it is sent with its length and false is returned, so
+   the handler is done
+*/
+static bool http_page_begin(SERVER_REQUEST *request, WRITER *w, const char *key = NULL)
+{
+  HTTP_CACHE_ENTRY *entry = key ? http_cache_lookup(key) : NULL;
+
+  WriterBegin(w, request->client, 200, "text/html");
+  if (entry) {
+    _http_cache_hits++;
+    WriterBody(w, entry->len);
+    WriterWrite(w, entry->data, entry->len);
+    if (!WriterEnd(w))
+      LogMsg("HTTP: client dropped the response after %lu bytes", w->bytes);
+    return false;
+  }
+
+  WriterBody(w, WRITER_CHUNKED);
+  if (key)
+    http_cache_begin(w, key);
+  WriterPrint(w, HTTP_HTML_HEADER);
+  WriterHtml(w, _config.device.name);
+  WriterPrint(w, "</h2></div>");
+  return true;
+}
+
+/*
+   finish a page
+*/
+static void http_page_end(WRITER *w)
+{
+  WriterPrint(w, HTTP_HTML_FOOTER);
+  if (_http_cache_capture)
+    http_cache_end(w);
+  if (!WriterEnd(w))
+    LogMsg("HTTP: client dropped the response after %lu bytes", w->bytes);
+}
+
+/*
+   start and finish a configuration form
+*/
+static void http_form_begin(WRITER *w, const char *legend)
+{
+  WriterPrintf(w, "<form method='get' action='/config'><fieldset><legend><b>&nbsp;%s&nbsp;</b></legend>", legend);
+}
+
+static void http_form_end(WRITER *w)
+{
+  WriterPrint(w,
+              "<button name='save' type='submit' class='button greenbg'>Speichern</button>"
+              "</fieldset>"
+              "</form>"
+              HTTP_CONFIG_MENU);
+}
+
+/*
+   write an input field of a form
+*/
+static void http_input(WRITER *w, const char *label, const char *name, const char *type, const char *placeholder, const char *value)
+{
+  WriterPrintf(w, "<b>%s</b><br><input name='%s' type='%s' placeholder='%s' value='", label, name, type, placeholder);
+  WriterHtml(w, value);
+  WriterPrint(w, "'><p>");
+}
+
+static void http_input_number(WRITER *w, const char *label, const char *name, const char *placeholder, int minimum, int maximum, int value)
+{
+  WriterPrintf(w, "<b>%s</b><br><input name='%s' type='number' placeholder='%s' min=%d max=%d value='%d'><p>", label, name, placeholder, minimum, maximum, value);
+}
+
+/*
+   write a row of the info table -- the value is written in between
+*/
+static void http_row_begin(WRITER *w, const char *name)
+{
+  WriterPrintf(w, "<tr><th>%s</th><td>", name);
+}
+
+static void http_row_end(WRITER *w)
+{
+  WriterPrint(w, "</td></tr>");
+}
+
+static void http_row_space(WRITER *w)
+{
+  WriterPrint(w, "<tr><th></th><td>&nbsp;</td></tr>");
+}
+
+static void http_row(WRITER *w, const char *name, const char *value)
+{
+  http_row_begin(w, name);
+  WriterHtml(w, value);
+  http_row_end(w);
+}
+
+/*
+   check the credentials of the request
+*/
+bool HttpAuthorized(SERVER_REQUEST *request, WRITER *w, bool always)
+{
+  if ((always || !StateCheck(STATE_CONFIGURING)) && _config.device.password[0] && !ServerAuthenticate(request, HTTP_WEB_USER, _config.device.password)) {
+    ServerRequestAuthentication(request, w);
+    return false;
+  }
+  return true;
+}
+
+/*
+   write the preset buttons and the form to save the current look
+*/
+static void http_presets(WRITER *w)
+{
+  WriterPrint(w, "<form action='/' method='get'>");
+  for (int n = 0; n < AOXA_PRESETS; n++)
+    if (_config.presets.entries[n].used)
+      WriterPrintf(w, "<button name='preset' value='%d' type='submit' style='width:auto;padding:0 1rem;margin:0.2rem;'>%d</button>", n + 1, n + 1);
+  WriterPrintf(w, "</form><p>"
+               "<form action='/' method='get'><b>Save as Preset</b><br><input name='preset_save' type='number' min=1 max=%d onchange='this.form.submit()'></form><p>", AOXA_PRESETS);
+}
+
+/*
+   the main page -- it is also the answer to any unknown path, so the
+   captive portal of the configuration mode ends up here
+*/
+static void http_handle_main(SERVER_REQUEST *request, WRITER *w)
+{
+  const char *arg;
+
+  /*
+     the static assets
+  */
+  for (unsigned int n = 0; n < sizeof(_assets) / sizeof(_assets[0]); n++)
+    if (!strcmp(request->path, _assets[n].path)) {
+      http_asset(request, w, &_assets[n]);
+      return;
+    }
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  if (ServerArg(request, "switch"))
+    AoxaNextMode();
+  if ((arg = ServerArg(request, "brightness")))
+    AoxaSetBrightness(atoi(arg));
+  if ((arg = ServerArg(request, "preset")))
+    AoxaRecallPreset(atoi(arg));
+  if ((arg = ServerArg(request, "preset_save")))
+    AoxaSavePreset(atoi(arg));
+
+  http_page_begin(request, w);
+  WriterPrintf(w, "<p><form action='/' method='get'><button name='switch' type='submit' class='button switch'>%s</button></form><p>", AoxaLookupMode(AoxaGetMode()));
+  WriterPrintf(w, "<form action='/' method='get'><b>Brightness</b><br><input name='brightness' type='range' min=%d max=%d value='%d' onchange='this.form.submit()'></form><p>",
+               AOXA_BRIGHTNESS_MIN, AOXA_BRIGHTNESS_MAX, AoxaGetBrightness());
+  http_presets(w);
+  WriterPrint(w,
+              "<form action='/config' method='get'><button>Configuration</button></form><p>"
+              "<form action='/info' method='get'><button>Information</button></form><p>"
+              "<form action='/restart' method='get' onsubmit=\"return confirm('Are you sure to restart the device?');\"><button class='button redbg'>Restart</button></form><p>"
+              "<div id='leds'></div>"
+              "<script src='/live.js?" ASSET_LIVE_JS_HASH "'></script>");
+  http_page_end(w);
+}
+
+/*
+   the configuration menu -- the forms of the configuration pages are sent here
+*/
+static void http_handle_config(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  /*
+     handle configuration changes
+  */
+#if DBG
+  for (int n = 0; n < request->args; n++ )
+    LogMsg("HTTP: args: %s=%s", request->arg_name[n], request->arg_value[n]);
+#endif
 
+  if (ServerArg(request, "save")) {
     /*
-        trigger reboot
+       take over the configuration parameters as described by the field table
     */
-    StateChange(STATE_WAIT_BEFORE_REBOOTING);
-  });
-
-  _WebServer.on("/info", []() {
-    _last_request = millis();
-    if (_config.device.password[0] && !_WebServer.authenticate(HTTP_WEB_USER, _config.device.password))
-      return _WebServer.requestAuthentication();
-
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<div class='info'>"
-                    "<table style='width:100%'"
-
-                    "<tr>"
-                    "<th>" __TITLE__ " Version</th>"
-                    "<td>" GIT_VERSION "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>Build Date</th>"
-                    "<td>" __DATE__ " " __TIME__ "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>Device Name</th>"
-                    "<td>" + String(_config.device.name) + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>Up since</th>"
-                    "<td>" + String(TimeToString(NtpUpSince())) + "</td>"
-                    "</tr>"
-
-                    "<tr><th></th><td>&nbsp;</td></tr>"
-
-                    "<tr>"
-                    "<th>WiFi SSID</th>"
-                    "<td>" + WifiGetSSID() + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>WiFi RSSI</th>"
-                    "<td>" + String(WIFI_RSSI_TO_QUALITY(WifiGetRSSI())) + "% (" + WifiGetRSSI() + "dBm)</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>WiFi MAC</th>"
-                    "<td>" + WifiGetMacAddr() + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>WiFi IP Address</th>"
-                    "<td>" + WifiGetIpAddr() + "</td>"
-                    "</tr>"
-
-                    "<tr><th></th><td>&nbsp;</td></tr>"
-
-                    "<tr>"
-                    "<th>NTP Server</th>"
-                    "<td>" + _config.ntp.server + "</td>"
-                    "</tr>"
-
-                    "<tr><th></th><td>&nbsp;</td></tr>"
-
-                    "<tr>"
-                    "<th>MQTT Host</th>"
-                    "<td>" + _config.mqtt.server + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Port</th>"
-                    "<td>" + _config.mqtt.port + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT User</th>"
-                    "<td>" + _config.mqtt.user + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Password</th>"
-                    "<td>" + _config.mqtt.password + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT ClientID</th>"
-                    "<td>" + _config.mqtt.clientID + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Topic Prefix</th>"
-                    "<td>" + _config.mqtt.topicPrefix + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Topic Telemetry</th>"
-                    "<td>" + _mqtt_topic_tele + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Topic Command</th>"
-                    "<td>" + _mqtt_topic_cmnd + "</td>"
-                    "</tr>"
-
-                    "<tr>"
-                    "<th>MQTT Topic Status</th>"
-                    "<td>" + _mqtt_topic_stat + "</td>"
-                    "</tr>"
-
-                    "<tr><th></th><td>&nbsp;</td></tr>"
-                    "</table>"
-
-                    "</div>"
-                    "<p><form action='/' method='get'><button>Main Menu</button></form><p>"
-                    + _html_footer);
-  });
-
-  _WebServer.on("/restart", []() {
-    _last_request = millis();
-    if (!StateCheck(STATE_CONFIGURING) && _config.device.password[0] && !_WebServer.authenticate(HTTP_WEB_USER, _config.device.password))
-      return _WebServer.requestAuthentication();
-
-    _WebServer.send(200, "text/html",
-                    _html_header +
-                    "<div class='msg'>"
-                    "Device will restart now."
-                    "</div>"
-                    "<p><form action='/' method='get'><button>Main Menu</button></form><p>"
-                    + _html_footer);
+    CONFIG config;
+    const char *value;
+
+    ConfigGet(0, sizeof(CONFIG), &config);
+    for (int n = 0; n < ConfigFields(); n++) {
+      const CONFIG_FIELD *field = ConfigField(n);
+
+      if ((value = ServerArg(request, field->name)))
+        ConfigParseField(field, value, strlen(value), &config);
+    }
+#if FEATURE_SCHEDULE
+    if ((value = ServerArg(request, "schedule_text"))) {
+      CONFIG_SCHEDULE schedule;
+
+      if (ScheduleParse(value, strlen(value), &schedule) >= 0)
+        config.schedule = schedule;
+    }
+#endif
 
     /*
-        trigger reboot
+       write the config back
     */
-    StateChange(STATE_WAIT_BEFORE_REBOOTING);
-  });
+    ConfigSet(0, sizeof(CONFIG), &config);
+  }
+
+  http_page_begin(request, w);
+  WriterPrint(w,
+              "<form action='/config/device' method='get'><button>Configure Device</button></form><p>"
+              "<form action='/config/wifi' method='get'><button>Configure WiFi</button></form><p>"
+#if FEATURE_NTP
+              "<form action='/config/ntp' method='get'><button>Configure NTP</button></form><p>"
+#endif
+#if FEATURE_MQTT
+              "<form action='/config/mqtt' method='get'><button>Configure MQTT</button></form><p>"
+#endif
+              "<form action='/config/leds' method='get'><button>Configure LEDs</button></form><p>"
+#if FEATURE_RULES
+              "<form action='/config/rules' method='get'><button>Configure Rules</button></form><p>"
+#endif
+#if FEATURE_SCHEDULE
+              "<form action='/config/schedule' method='get'><button>Configure Schedule</button></form><p>"
+#endif
+              "<form action='/config/reset' method='get' onsubmit=\"return confirm('Are you sure to reset the configuration?');\"><button class='button redbg'>Reset configuration</button></form><p>"
+              HTTP_MAIN_MENU);
+  http_page_end(w);
+}
+
+static void http_handle_config_device(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!http_page_begin(request, w, "/config/device"))
+    return;
+  http_form_begin(w, "Device");
+  http_input(w, "Name", "device_name", "text", "Device name", _config.device.name);
+  http_input(w, "Web Password", "device_password", "password", "Device Password", _config.device.password);
+  WriterPrint(w, "<b>Note:</b> username for authentication is <b>" HTTP_WEB_USER "</b><p>");
+  http_form_end(w);
+  http_page_end(w);
+}
+
+/*
+   the WiFi form offers the networks of the background scan for the SSID
+*/
+static void http_handle_config_wifi(SERVER_REQUEST *request, WRITER *w)
+{
+  const WIFI_NETWORK *networks;
+  int count = WifiGetNetworks(&networks);
+
+  http_page_begin(request, w);
+  http_form_begin(w, "WiFi");
+  WriterPrint(w, "<b>SSID</b><br><input name='wifi_ssid' type='text' list='networks' placeholder='WiFi SSID' value='");
+  WriterHtml(w, _config.wifi.ssid);
+  WriterPrint(w, "'><p><datalist id='networks'>");
+  for (int n = 0; n < count; n++) {
+    WriterPrint(w, "<option value='");
+    WriterHtml(w, networks[n].ssid);
+    WriterPrint(w, "'>");
+  }
+  WriterPrint(w, "</datalist>");
+  http_input(w, "Password", "wifi_psk", "password", "WiFi Password", _config.wifi.psk);
+
+  WriterPrint(w, "<div class='info'><table style='width:100%'>");
+  for (int n = 0; n < count; n++) {
+    WriterPrint(w, "<tr><th>");
+    WriterHtml(w, networks[n].ssid);
+    WriterPrintf(w, "</th><td>%d%% (%ddBm), channel %d%s</td></tr>",
+                 WIFI_RSSI_TO_QUALITY(networks[n].rssi), networks[n].rssi, networks[n].channel, networks[n].secure ? "" : ", open");
+  }
+  if (WifiGetNetworksAge() < 0)
+    WriterPrint(w, "<tr><th></th><td>scanning for networks ...</td></tr>");
+  WriterPrint(w, "</table></div><p>");
+  http_form_end(w);
+  http_page_end(w);
+}
+
+#if FEATURE_NTP
+static void http_handle_config_ntp(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!http_page_begin(request, w, "/config/ntp"))
+    return;
+  http_form_begin(w, "NTP");
+  http_input(w, "Server", "ntp_server", "text", "NTP server", _config.ntp.server);
+  http_form_end(w);
+  http_page_end(w);
+}
+#endif
+
+#if FEATURE_MQTT
+static void http_handle_config_mqtt(SERVER_REQUEST *request, WRITER *w)
+{
+  char port[8];
+
+  if (!http_page_begin(request, w, "/config/mqtt"))
+    return;
+  snprintf(port, sizeof(port), "%d", _config.mqtt.port);
+  http_form_begin(w, "MQTT");
+  http_input(w, "Server", "mqtt_server", "text", "MQTT server", _config.mqtt.server);
+  http_input(w, "Port", "mqtt_port", "text", "MQTT port", port);
+  http_input(w, "User (optional)", "mqtt_user", "text", "MQTT user", _config.mqtt.user);
+  http_input(w, "Password (optional)", "mqtt_password", "text", "MQTT password", _config.mqtt.password);
+  http_input(w, "ClientID", "mqtt_clientID", "text", "MQTT ClientID", _config.mqtt.clientID);
+  http_input(w, "TopicPrefix", "mqtt_topicPrefix", "text", "MQTT Topic Prefix", _config.mqtt.topicPrefix);
+  http_form_end(w);
+  http_page_end(w);
+}
+#endif
+
+static void http_handle_config_leds(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!http_page_begin(request, w, "/config/leds"))
+    return;
+  http_form_begin(w, "LEDs");
+  http_input_number(w, "Startup Mode", "aoxa_default_mode", "Startup Mode", AOXA_MODE_OFF, AOXA_MODE_LAST - 1, _config.aoxa.default_mode);
+  http_input_number(w, "Fade Speed [ms]", "aoxa_fade_speed", "LED Fade Speed", AOXA_FADE_SPEED_MIN, AOXA_FADE_SPEED_MAX, _config.aoxa.fade_speed);
+  http_input_number(w, "Flash Speed [ms]", "aoxa_flash_speed", "LED Flash Speed", AOXA_FLASH_SPEED_MIN, AOXA_FLASH_SPEED_MAX, _config.aoxa.flash_speed);
+  http_input_number(w, "Blink Speed [ms]", "aoxa_blink_speed", "LED Blink Speed", AOXA_BLINK_SPEED_MIN, AOXA_BLINK_SPEED_MAX, _config.aoxa.blink_speed);
+  http_input_number(w, "Fire Speed [ms]", "aoxa_fire_speed", "LED Fire Speed", AOXA_FIRE_SPEED_MIN, AOXA_FIRE_SPEED_MAX, _config.aoxa.fire_speed);
+  http_input(w, "LED Pins", "aoxa_pins", "text", AOXA_PINS_DEFAULT, _config.aoxa.pins);
+  WriterPrintf(w, "<b>Note:</b> up to %d comma separated GPIOs, changes take effect after a restart<p>", AOXA_LEDS_MAX);
+  http_form_end(w);
+  http_page_end(w);
+}
+
+#if FEATURE_RULES
+static void http_handle_config_rules(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!http_page_begin(request, w, "/config/rules"))
+    return;
+  http_form_begin(w, "Rules");
+  WriterPrintf(w, "<b>Rules</b> (%d active", RulesCount());
+  if (RulesError()[0]) {
+    WriterPrint(w, ", ");
+    WriterHtml(w, RulesError());
+  }
+  WriterPrint(w, ")<br><textarea name='rules_text' rows='10' style='width:90%' placeholder='ON mqtt#disconnected DO mode BLINK'>");
+  WriterHtml(w, _config.rules.text);
+  WriterPrint(w, "</textarea><p>"
+              "<b>Note:</b> one rule per line: <b>ON</b> trigger [<b>IF</b> condition] <b>DO</b> action<p>");
+  http_form_end(w);
+  http_page_end(w);
+}
+#endif
+
+#if FEATURE_SCHEDULE
+static void http_handle_config_schedule(SERVER_REQUEST *request, WRITER *w)
+{
+  const char *line;
+
+  http_page_begin(request, w);
+  http_form_begin(w, "Schedule");
+  WriterPrintf(w, "<b>Schedule</b> (next: %s)", ScheduleNext() ? TimeToString(ScheduleNext()) : "none");
+  WriterPrint(w, "<br><textarea name='schedule_text' rows='10' style='width:90%' placeholder='weekday 19:00 FIRE'>");
+  for (unsigned int n = 0; n < SCHEDULE_ENTRIES; n++)
+    if ((line = ScheduleEntryToString(&_config.schedule.entries[n])))
+      WriterHtml(w, line);
+  WriterPrint(w, "</textarea><p>"
+              "<b>Note:</b> one entry per line: [days] HH:MM mode, times are UTC<p>");
+  http_form_end(w);
+  http_page_end(w);
+}
+#endif
+
+static void http_handle_config_reset(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  /*
+     reset the config
+  */
+  ConfigReset();
+
+  http_page_begin(request, w);
+  WriterPrint(w,
+              "<div class='msg'>"
+              "Configuration was reset."
+              "<p>"
+              "Wait for the device to come up with an WiFi-AccessPoint, connect to it to configure the device."
+              "</div>");
+  http_page_end(w);
+
+  /*
+      trigger reboot
+  */
+  StateChange(STATE_WAIT_BEFORE_REBOOTING);
+}
+
+/*
+   the rows of the info page which change with the config or the
+   connectivity only
+*/
+static void http_info_static(WRITER *w)
+{
+  http_row(w, __TITLE__ " Version", GIT_VERSION);
+  http_row(w, "Build Date", __DATE__ " " __TIME__);
+  http_row(w, "Device Name", _config.device.name);
+  http_row_space(w);
+
+  http_row(w, "WiFi SSID", WifiGetSSID());
+  http_row(w, "WiFi MAC", WifiGetMacAddr());
+  http_row(w, "WiFi IP Address", WifiGetIpAddr());
+  http_row_space(w);
+
+#if FEATURE_NTP
+  http_row(w, "NTP Server", _config.ntp.server);
+  http_row_space(w);
+#endif
+
+#if FEATURE_MQTT
+  http_row(w, "MQTT Host", _config.mqtt.server);
+  http_row_begin(w, "MQTT Port");
+  WriterPrintf(w, "%d", _config.mqtt.port);
+  http_row_end(w);
+  http_row(w, "MQTT User", _config.mqtt.user);
+  http_row(w, "MQTT Password", _config.mqtt.password);
+  http_row(w, "MQTT ClientID", _config.mqtt.clientID);
+  http_row(w, "MQTT Topic Prefix", _config.mqtt.topicPrefix);
+  http_row(w, "MQTT Topic Telemetry", _mqtt_topic_tele.c_str());
+  http_row(w, "MQTT Topic Command", _mqtt_topic_cmnd.c_str());
+  http_row(w, "MQTT Topic Status", _mqtt_topic_stat.c_str());
+  http_row_space(w);
+#endif
+
+  http_row_begin(w, "LED Pins");
+  for (int led = 0; led < AoxaLeds(); led++)
+    WriterPrintf(w, led ? ", %d" : "%d", AoxaLedPin(led));
+  http_row_end(w);
+  http_row_space(w);
+}
+
+static void http_handle_info(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!HttpAuthorized(request, w, true))
+    return;
+
+  http_page_begin(request, w);
+  WriterPrint(w, "<div class='info'><table style='width:100%'>");
+
+  /*
+     the counters change all the time, only the rows above them are cached
+  */
+  if (!http_cached(w, "/info")) {
+    http_info_static(w);
+    http_cache_end(w);
+  }
+
+#if FEATURE_NTP
+  http_row(w, "Up since", TimeToString(NtpUpSince()));
+#endif
+  http_row_begin(w, "WiFi RSSI");
+  WriterPrintf(w, "%d%% (%ddBm)", WIFI_RSSI_TO_QUALITY(WifiGetRSSI()), WifiGetRSSI());
+  http_row_end(w);
+  http_row_space(w);
+  http_row_begin(w, "Boot Phases");
+  for (int n = 0; n < BootPhases(); n++)
+    WriterPrintf(w, "%s%s %lums", n ? ", " : "", BootPhaseName(n), BootPhaseTime(n));
+  http_row_end(w);
+
+  http_row_begin(w, "Config Commits");
+  WriterPrintf(w, "%lu (%lu bytes)", ConfigCommits(), ConfigBytesWritten());
+  http_row_end(w);
+
+  http_row_begin(w, "Journal Records");
+  WriterPrintf(w, "%lu (%lu bytes, %lu erases)", JournalRecords(), JournalBytesWritten(), JournalErases());
+  http_row_end(w);
+
+  http_row_begin(w, "Events Mode/WiFi/MQTT/Config");
+  WriterPrintf(w, "%lu/%lu/%lu/%lu", EventCount(EVENT_AOXA_MODE), EventCount(EVENT_WIFI), EventCount(EVENT_MQTT), EventCount(EVENT_CONFIG));
+  http_row_end(w);
+
+  http_row_begin(w, "Events Dropped");
+  WriterPrintf(w, "%lu", EventDropped());
+  http_row_end(w);
+  http_row_space(w);
+
+  http_row_begin(w, "HTTP Requests/Reused");
+  WriterPrintf(w, "%lu/%lu", ServerStats()->requests, ServerStats()->reused);
+  http_row_end(w);
+
+  http_row_begin(w, "HTTP Rate Limited/Busy");
+  WriterPrintf(w, "%lu/%lu", ServerStats()->rate_limited, ServerStats()->busy);
+  http_row_end(w);
+
+  http_row_begin(w, "HTTP Rejected/Deferred/Timeouts");
+  WriterPrintf(w, "%lu/%lu/%lu", ServerStats()->rejected, ServerStats()->deferred, ServerStats()->timeouts);
+  http_row_end(w);
+
+  http_row_begin(w, "HTTP Page Cache Hits/Misses");
+  WriterPrintf(w, "%lu/%lu", _http_cache_hits, _http_cache_misses);
+  http_row_end(w);
+  http_row_space(w);
+
+  WriterPrint(w, "</table></div>" HTTP_MAIN_MENU);
+  http_page_end(w);
+}
+
+static void http_handle_restart(SERVER_REQUEST *request, WRITER *w)
+{
+  if (!HttpAuthorized(request, w, false))
+    return;
+
+  http_page_begin(request, w);
+  WriterPrint(w,
+              "<div class='msg'>"
+              "Device will restart now."
+              "</div>"
+              HTTP_MAIN_MENU);
+  http_page_end(w);
+
+  /*
+      trigger reboot
+  */
+  StateChange(STATE_WAIT_BEFORE_REBOOTING);
+}
+
+/*
+   the routes -- anything else goes to the main page
+*/
+static const SERVER_ROUTE _http_routes[] = {
+  { "/config", http_handle_config, 0 },
+  { "/config/device", http_handle_config_device, 0 },
+  { "/config/wifi", http_handle_config_wifi, 0 },
+#if FEATURE_NTP
+  { "/config/ntp", http_handle_config_ntp, 0 },
+#endif
+#if FEATURE_MQTT
+  { "/config/mqtt", http_handle_config_mqtt, 0 },
+#endif
+  { "/config/leds", http_handle_config_leds, 0 },
+#if FEATURE_RULES
+  { "/config/rules", http_handle_config_rules, 0 },
+#endif
+#if FEATURE_SCHEDULE
+  { "/config/schedule", http_handle_config_schedule, 0 },
+#endif
+  { "/config/reset", http_handle_config_reset, 0 },
+  { "/info", http_handle_info, 0 },
+  { "/restart", http_handle_restart, 0 },
+  { API_PATH_STATE, ApiState, 0 },
+  { API_PATH_MODE, ApiMode, SERVER_ROUTE_PREFIX },
+  { API_PATH_CONFIG, ApiConfig, 0 },
+  { API_PATH_INFO, ApiInfo, 0 },
+  { API_PATH_NETWORKS, ApiNetworks, 0 },
+  { SSE_PATH, SseSubscribe, 0 },
+#if FEATURE_OTA
+  { OTA_PATH, OtaUpload, SERVER_ROUTE_STREAM },
+#endif
+};
 
-  _WebServer.begin();
-  _last_request = millis();
+/*
+   setup the webserver
+*/
+void HttpSetup(void)
+{
+  LogMsg("HTTP: setting up HTTP server");
+  ServerSetup(_http_routes, sizeof(_http_routes) / sizeof(_http_routes[0]), http_handle_main);
+  EventSubscribe("http", EVENT_MASK(EVENT_CONFIG) | EVENT_MASK(EVENT_WIFI) | EVENT_MASK(EVENT_MQTT), http_event_handler);
+  SseSetup();
   LogMsg("HTTP: server started");
 }
 
@@ -510,7 +810,8 @@ void HttpSetup(void)
 */
 void HttpUpdate(void)
 {
-  _WebServer.handleClient();
+  ServerUpdate();
+  SseUpdate();
 }
 
 /*
@@ -518,5 +819,9 @@ void HttpUpdate(void)
 */
 int HttpLastRequest(void)
 {
-  return (millis() - _last_request) / 1000;
-}/**/
+  return (millis() - ServerLastRequest()) / 1000;
+}
+
+#endif
+
+/**/
@@ -28,12 +28,20 @@
 
 #include "config.h"
 #include "util.h"
+#include "server.h"
 
 /*
    user for the Basic Auth
 */
 #define HTTP_WEB_USER   "admin"
 
+/*
+   the rendered pages are cached in this number of entries of this size
+   [bytes] -- a page which doesn't fit is rendered on every request
+*/
+#define HTTP_CACHE_ENTRIES  4
+#define HTTP_CACHE_SIZE     3072
+
 /*
 **  setup the HTTP web server:w
 */
@@ -44,6 +52,14 @@ void HttpSetup(void);
 */
 void HttpUpdate(void);
 
+/*
+   check the credentials of the request -- they are needed if a password
+   is set, and in the configuration mode only if always is set
+
+   returns false if the request was answered with a request for credentials
+*/
+bool HttpAuthorized(SERVER_REQUEST *request, WRITER *w, bool always);
+
 /*
   return the time in seconds since the last HTTP request
  */
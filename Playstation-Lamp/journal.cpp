@@ -0,0 +1,298 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the config journal in the flash
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_partition.h>
+#include "config.h"
+#include "journal.h"
+#include "util.h"
+
+#define JOURNAL_SECTOR_SIZE     SPI_FLASH_SEC_SIZE
+#define JOURNAL_RECORD_MAGIC    0x4a54    // JT
+
+/*
+   record types
+*/
+enum JOURNAL_RECORD_TYPE {
+  JOURNAL_RECORD_SNAPSHOT = 1,
+  JOURNAL_RECORD_DELTA,
+};
+
+/*
+   the record header -- followed by the data, padded to 4 bytes
+*/
+typedef struct {
+  uint16_t magic;
+  uint8_t type;
+  uint8_t reserved;
+  uint32_t seq;
+  uint16_t len;       // length of the data
+  uint16_t reserved2;
+  uint32_t crc;       // CRC32 over the header up to here and the data
+} JOURNAL_RECORD;
+
+#define JOURNAL_ALIGN(len)      (((len) + 3) & ~3)
+#define JOURNAL_RECORD_SIZE(len)  (sizeof(JOURNAL_RECORD) + JOURNAL_ALIGN(len))
+
+/*
+   the journal context
+*/
+static const esp_partition_t *_journal_partition = NULL;
+static int _journal_sector = -1;    // the active sector, or -1 if there is none
+static int _journal_pos = 0;        // the write position in the active sector
+static uint32_t _journal_seq = 0;   // the sequence number of the last record
+
+/*
+   statistics
+*/
+static unsigned long _journal_records = 0;
+static unsigned long _journal_bytes_written = 0;
+static unsigned long _journal_erases = 0;
+
+/*
+   compute the CRC of the record, the data is read from the flash in chunks
+*/
+static uint32_t journal_record_crc(const JOURNAL_RECORD *record, int addr)
+{
+  byte chunk[64];
+  uint32_t crc = Crc32(record, offsetof(JOURNAL_RECORD, crc));
+
+  for (int n = 0; n < record->len; n += sizeof(chunk)) {
+    int len = min((int) sizeof(chunk), record->len - n);
+
+    esp_partition_read(_journal_partition, addr + sizeof(JOURNAL_RECORD) + n, chunk, len);
+    crc = Crc32(chunk, len, crc);
+  }
+  return crc;
+}
+
+/*
+   read and validate the record at the given address
+
+   returns false if the record is blank or invalid
+*/
+static bool journal_read_record(int addr, JOURNAL_RECORD *record)
+{
+  if (addr % JOURNAL_SECTOR_SIZE + (int) sizeof(JOURNAL_RECORD) > JOURNAL_SECTOR_SIZE)
+    return false;
+  if (esp_partition_read(_journal_partition, addr, record, sizeof(JOURNAL_RECORD)) != ESP_OK)
+    return false;
+  if (record->magic != JOURNAL_RECORD_MAGIC)
+    return false;
+  if (addr % JOURNAL_SECTOR_SIZE + (int) JOURNAL_RECORD_SIZE(record->len) > JOURNAL_SECTOR_SIZE)
+    return false;
+  return journal_record_crc(record, addr) == record->crc;
+}
+
+/*
+   check if the given flash range is blank
+*/
+static bool journal_blank(int addr, int len)
+{
+  uint32_t chunk[16];
+
+  while (len > 0) {
+    int n = min((int) sizeof(chunk), len);
+
+    esp_partition_read(_journal_partition, addr, chunk, n);
+    for (int i = 0; i < n / (int) sizeof(uint32_t); i++)
+      if (chunk[i] != 0xffffffff)
+        return false;
+    addr += n;
+    len -= n;
+  }
+  return true;
+}
+
+/*
+   write a record with the given data at the current position
+
+   the data is written first, the header last -- so the record
+   becomes valid only if it was written completely
+*/
+static bool journal_write_record(int type, const void *data, int len)
+{
+  JOURNAL_RECORD record;
+  int addr = _journal_sector * JOURNAL_SECTOR_SIZE + _journal_pos;
+
+  record.magic = JOURNAL_RECORD_MAGIC;
+  record.type = type;
+  record.reserved = 0xff;
+  record.seq = _journal_seq + 1;
+  record.len = len;
+  record.reserved2 = 0xffff;
+  record.crc = Crc32(data, len, Crc32(&record, offsetof(JOURNAL_RECORD, crc)));
+
+  if (esp_partition_write(_journal_partition, addr + sizeof(JOURNAL_RECORD), data, len) != ESP_OK
+      || esp_partition_write(_journal_partition, addr, &record, sizeof(record)) != ESP_OK) {
+    LogMsg("JOURNAL: writing record %u at 0x%x failed", record.seq, addr);
+    return false;
+  }
+
+  _journal_seq = record.seq;
+  _journal_pos += JOURNAL_RECORD_SIZE(len);
+  _journal_records++;
+  _journal_bytes_written += JOURNAL_RECORD_SIZE(len);
+  return true;
+}
+
+/*
+   setup the journal and replay the records of the newest snapshot
+
+   returns false if no valid snapshot was found
+*/
+bool JournalSetup(JOURNAL_REPLAY replay)
+{
+  JOURNAL_RECORD record;
+  uint32_t seq = 0;
+  int addr;
+
+  _journal_sector = -1;
+
+  if (!(_journal_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, JOURNAL_PARTITION_LABEL))
+      || _journal_partition->size < JOURNAL_SECTORS * JOURNAL_SECTOR_SIZE) {
+    LogMsg("JOURNAL: no usable partition %s found", JOURNAL_PARTITION_LABEL);
+    _journal_partition = NULL;
+    return false;
+  }
+
+  /*
+     find the sector with the newest valid snapshot
+  */
+  for (int sector = 0; sector < JOURNAL_SECTORS; sector++) {
+    if (journal_read_record(sector * JOURNAL_SECTOR_SIZE, &record) && record.type == JOURNAL_RECORD_SNAPSHOT
+        && (_journal_sector < 0 || record.seq > seq)) {
+      _journal_sector = sector;
+      seq = record.seq;
+    }
+  }
+  if (_journal_sector < 0) {
+    LogMsg("JOURNAL: no valid snapshot found");
+    return false;
+  }
+
+  /*
+     replay the records of this sector in order
+  */
+  for (_journal_pos = 0; journal_read_record(addr = _journal_sector * JOURNAL_SECTOR_SIZE + _journal_pos, &record); _journal_pos += JOURNAL_RECORD_SIZE(record.len)) {
+    byte *data;
+
+    if (_journal_pos && (record.type != JOURNAL_RECORD_DELTA || record.seq != _journal_seq + 1))
+      break;
+    if (!(data = (byte *) malloc(record.len + 1)))
+      break;
+    esp_partition_read(_journal_partition, addr + sizeof(JOURNAL_RECORD), data, record.len);
+    replay(data, record.len);
+    free(data);
+    _journal_seq = record.seq;
+  }
+
+  LogMsg("JOURNAL: recovered sequence %u from sector %d, %d bytes used", _journal_seq, _journal_sector, _journal_pos);
+  return true;
+}
+
+/*
+   append a delta record to the journal
+
+   returns false if there is no room left in the active sector or the
+   write failed -- a snapshot has to be written with JournalCompact() then
+*/
+bool JournalWrite(const void *data, int len)
+{
+  /*
+     the space has to be blank -- it might not be because of an interrupted write
+  */
+  if (!_journal_partition || _journal_sector < 0
+      || _journal_pos + (int) JOURNAL_RECORD_SIZE(len) > JOURNAL_SECTOR_SIZE
+      || !journal_blank(_journal_sector * JOURNAL_SECTOR_SIZE + _journal_pos, JOURNAL_RECORD_SIZE(len)))
+    return false;
+
+  DbgMsg("JOURNAL: appending delta %u: len:%d", _journal_seq + 1, len);
+  return journal_write_record(JOURNAL_RECORD_DELTA, data, len);
+}
+
+/*
+   write a snapshot record into the next sector
+*/
+bool JournalCompact(const void *data, int len)
+{
+  if (!_journal_partition)
+    return false;
+  if ((int) JOURNAL_RECORD_SIZE(len) > JOURNAL_SECTOR_SIZE) {
+    LogMsg("JOURNAL: snapshot of %d bytes doesn't fit into a sector", len);
+    return false;
+  }
+
+  _journal_sector = (_journal_sector + 1) % JOURNAL_SECTORS;
+  _journal_pos = 0;
+
+  LogMsg("JOURNAL: writing snapshot %u into sector %d", _journal_seq + 1, _journal_sector);
+  if (esp_partition_erase_range(_journal_partition, _journal_sector * JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_SIZE) != ESP_OK) {
+    LogMsg("JOURNAL: erasing sector %d failed", _journal_sector);
+    return false;
+  }
+  _journal_erases++;
+  return journal_write_record(JOURNAL_RECORD_SNAPSHOT, data, len);
+}
+
+/*
+   erase all sectors of the journal
+*/
+void JournalReset(void)
+{
+  if (!_journal_partition)
+    return;
+
+  LogMsg("JOURNAL: erasing all sectors");
+  esp_partition_erase_range(_journal_partition, 0, JOURNAL_SECTORS * JOURNAL_SECTOR_SIZE);
+  _journal_erases += JOURNAL_SECTORS;
+  _journal_sector = -1;
+  _journal_pos = 0;
+}
+
+/*
+   get the number of records written since boot
+*/
+unsigned long JournalRecords(void)
+{
+  return _journal_records;
+}
+
+/*
+   get the number of bytes written since boot
+*/
+unsigned long JournalBytesWritten(void)
+{
+  return _journal_bytes_written;
+}
+
+/*
+   get the number of sector erases since boot
+*/
+unsigned long JournalErases(void)
+{
+  return _journal_erases;
+}/**/
@@ -0,0 +1,106 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the config journal in the flash
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__ 1
+
+#include <Arduino.h>
+
+/*
+   the journal is kept in the first sectors of this data partition
+
+   the sketch doesn't use SPIFFS, so the partition available in
+   the common partition schemes is reused
+*/
+#define JOURNAL_PARTITION_LABEL   "spiffs"
+
+/*
+   number of flash sectors used round robin by the journal
+*/
+#define JOURNAL_SECTORS           4
+
+/*
+   layout of the journal
+
+   each sector starts with a snapshot record holding the full data,
+   followed by delta records holding changes:
+
+      [snapshot seq n][delta seq n+1][delta seq n+2]...[blank]
+
+   each record carries a sequence number and a CRC over its header and
+   data, the header is written after the data, so a record is only valid
+   once it is completely written
+
+   if a sector is full, the full data is written as a snapshot into the
+   next sector -- the older sectors stay intact until they are reused
+
+   the journal doesn't interpret the data, the records are handed back
+   in order on the replay
+*/
+typedef void (*JOURNAL_REPLAY)(const byte *data, int len);
+
+/*
+   setup the journal and replay the records of the newest snapshot
+
+   returns false if no valid snapshot was found
+*/
+bool JournalSetup(JOURNAL_REPLAY replay);
+
+/*
+   append a delta record to the journal
+
+   returns false if there is no room left in the active sector or the
+   write failed -- a snapshot has to be written with JournalCompact() then
+*/
+bool JournalWrite(const void *data, int len);
+
+/*
+   write a snapshot record into the next sector
+*/
+bool JournalCompact(const void *data, int len);
+
+/*
+   erase all sectors of the journal
+*/
+void JournalReset(void);
+
+/*
+   get the number of records written since boot
+*/
+unsigned long JournalRecords(void);
+
+/*
+   get the number of bytes written since boot
+*/
+unsigned long JournalBytesWritten(void);
+
+/*
+   get the number of sector erases since boot
+*/
+unsigned long JournalErases(void);
+
+#endif
+
+/**/
@@ -0,0 +1,368 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to write and parse JSON
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <string.h>
+#include "json.h"
+
+/*
+   the flags of the levels beyond JSON_DEPTH_MAX are shared
+*/
+#define JSON_LEVEL(json)  ((json)->depth < JSON_DEPTH_MAX ? (json)->depth : JSON_DEPTH_MAX - 1)
+
+/*
+   write the separator in front of a member and its name
+*/
+static void json_member(JSON *json, const char *name)
+{
+  if (json->members[JSON_LEVEL(json)])
+    WriterWrite(json->writer, ",", 1);
+  json->members[JSON_LEVEL(json)] = true;
+  if (name)
+    WriterPrintf(json->writer, "\"%s\":", name);
+}
+
+/*
+   open and close a level
+*/
+static void json_open(JSON *json, const char *name, char bracket)
+{
+  json_member(json, name);
+  WriterWrite(json->writer, &bracket, 1);
+  json->depth++;
+  json->members[JSON_LEVEL(json)] = false;
+}
+
+static void json_close(JSON *json, char bracket)
+{
+  json->depth--;
+  WriterWrite(json->writer, &bracket, 1);
+}
+
+/*
+   start a JSON document
+*/
+void JsonBegin(JSON *json, WRITER *writer)
+{
+  json->writer = writer;
+  json->depth = 1;
+  json->members[1] = false;
+  WriterWrite(writer, "{", 1);
+}
+
+/*
+   finish a JSON document -- open levels are closed as objects
+*/
+void JsonEnd(JSON *json)
+{
+  while (json->depth > 0)
+    json_close(json, '}');
+}
+
+/*
+   start and finish a nested object or array
+*/
+void JsonObjectBegin(JSON *json, const char *name)
+{
+  json_open(json, name, '{');
+}
+
+void JsonObjectEnd(JSON *json)
+{
+  json_close(json, '}');
+}
+
+void JsonArrayBegin(JSON *json, const char *name)
+{
+  json_open(json, name, '[');
+}
+
+void JsonArrayEnd(JSON *json)
+{
+  json_close(json, ']');
+}
+
+/*
+   write a string -- the runs without special characters are written at once
+*/
+void JsonString(JSON *json, const char *name, const char *value)
+{
+  const char *start = value;
+
+  json_member(json, name);
+  WriterWrite(json->writer, "\"", 1);
+  for (; *value; value++) {
+    unsigned char c = *value;
+
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    WriterWrite(json->writer, start, value - start);
+    if (c == '"' || c == '\\') {
+      char escaped[2] = { '\\', (char) c };
+
+      WriterWrite(json->writer, escaped, 2);
+    }
+    else if (c == '\n')
+      WriterWrite(json->writer, "\\n", 2);
+    else
+      WriterPrintf(json->writer, "\\u%04x", c);
+    start = value + 1;
+  }
+  WriterWrite(json->writer, start, value - start);
+  WriterWrite(json->writer, "\"", 1);
+}
+
+/*
+   write a number, a boolean or null
+*/
+void JsonInt(JSON *json, const char *name, long value)
+{
+  json_member(json, name);
+  WriterPrintf(json->writer, "%ld", value);
+}
+
+void JsonUnsigned(JSON *json, const char *name, unsigned long value)
+{
+  json_member(json, name);
+  WriterPrintf(json->writer, "%lu", value);
+}
+
+void JsonBool(JSON *json, const char *name, bool value)
+{
+  json_member(json, name);
+  WriterPrint(json->writer, value ? "true" : "false");
+}
+
+void JsonNull(JSON *json, const char *name)
+{
+  json_member(json, name);
+  WriterPrint(json->writer, "null");
+}
+
+/*
+   skip the white space
+*/
+static char *json_skip(char *p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+    p++;
+  return p;
+}
+
+/*
+   get the value of a hex digit, or -1
+*/
+static int json_hex(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/*
+   unescape the string starting behind the opening quote in place
+
+   the result is never longer than the escaped text, so it is written
+   over it -- returns the position behind the closing quote, or NULL
+*/
+static char *json_string(char *p)
+{
+  char *out = p;
+
+  while (*p != '"') {
+    if (!*p || (unsigned char) *p < 0x20)
+      return NULL;
+    if (*p != '\\') {
+      *out++ = *p++;
+      continue;
+    }
+    switch (*++p) {
+      case '"': case '\\': case '/': *out++ = *p; break;
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u': {
+          long code = 0;
+
+          for (int n = 1; n <= 4; n++) {
+            int digit = json_hex(p[n]);
+
+            if (digit < 0)
+              return NULL;
+            code = code << 4 | digit;
+          }
+          p += 4;
+
+          /*
+             a surrogate pair is decoded into one code point
+          */
+          if (code >= 0xd800 && code < 0xdc00 && p[1] == '\\' && p[2] == 'u') {
+            long low = 0;
+
+            for (int n = 3; n <= 6; n++) {
+              int digit = json_hex(p[n]);
+
+              if (digit < 0)
+                return NULL;
+              low = low << 4 | digit;
+            }
+            if (low >= 0xdc00 && low < 0xe000) {
+              code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+              p += 6;
+            }
+          }
+
+          /*
+             encode as UTF-8
+          */
+          if (code < 0x80)
+            *out++ = code;
+          else if (code < 0x800) {
+            *out++ = 0xc0 | (code >> 6);
+            *out++ = 0x80 | (code & 0x3f);
+          }
+          else if (code < 0x10000) {
+            *out++ = 0xe0 | (code >> 12);
+            *out++ = 0x80 | ((code >> 6) & 0x3f);
+            *out++ = 0x80 | (code & 0x3f);
+          }
+          else {
+            *out++ = 0xf0 | (code >> 18);
+            *out++ = 0x80 | ((code >> 12) & 0x3f);
+            *out++ = 0x80 | ((code >> 6) & 0x3f);
+            *out++ = 0x80 | (code & 0x3f);
+          }
+          break;
+        }
+      default:
+        return NULL;
+    }
+    p++;
+  }
+  *out = '\0';
+  return p + 1;
+}
+
+/*
+   start parsing the given text
+*/
+void JsonParseBegin(JSON_PARSER *parser, char *text)
+{
+  parser->next = text;
+  parser->delimiter = '\0';
+}
+
+/*
+   get the next member of the object
+*/
+int JsonParseMember(JSON_PARSER *parser, char **name, char **value, int *type)
+{
+  static const struct {
+    const char *text;
+    int len;
+    int type;
+  } literals[] = {
+    { "true", 4, JSON_TYPE_TRUE },
+    { "false", 5, JSON_TYPE_FALSE },
+    { "null", 4, JSON_TYPE_NULL },
+  };
+  char *p = json_skip(parser->next);
+  char *end;
+
+  /*
+     the opening brace, or the delimiter behind the previous member
+  */
+  if (!parser->delimiter) {
+    if (*p++ != '{')
+      return -1;
+    p = json_skip(p);
+    if (*p == '}') {
+      parser->delimiter = '}';
+      parser->next = p + 1;
+      return *json_skip(p + 1) ? -1 : 0;
+    }
+  }
+  else if (parser->delimiter == '}')
+    return *p ? -1 : 0;
+
+  /*
+     the name
+  */
+  if (*p++ != '"' || !(end = json_string(p)))
+    return -1;
+  *name = p;
+  p = json_skip(end);
+  if (*p++ != ':')
+    return -1;
+
+  /*
+     the value
+  */
+  p = json_skip(p);
+  if (*p == '"') {
+    if (!(end = json_string(++p)))
+      return -1;
+    *type = JSON_TYPE_STRING;
+  }
+  else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+    end = p + 1;
+    while ((*end >= '0' && *end <= '9') || *end == '.' || *end == 'e' || *end == 'E' || *end == '+' || *end == '-')
+      end++;
+    *type = JSON_TYPE_NUMBER;
+  }
+  else {
+    unsigned int n;
+
+    for (n = 0; n < sizeof(literals) / sizeof(literals[0]); n++)
+      if (!strncmp(p, literals[n].text, literals[n].len))
+        break;
+    if (n >= sizeof(literals) / sizeof(literals[0]))
+      return -1;
+    end = p + literals[n].len;
+    *type = literals[n].type;
+  }
+  *value = p;
+
+  /*
+     the delimiter behind the value has to be a separator or the closing
+     brace -- it is remembered, as the terminator of the value may
+     overwrite it
+  */
+  p = json_skip(end);
+  if (*p != ',' && *p != '}')
+    return -1;
+  parser->delimiter = *p;
+  parser->next = p + 1;
+  if (*type != JSON_TYPE_STRING)
+    *end = '\0';
+  return 1;
+}
+
+/**/
@@ -0,0 +1,109 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to write and parse JSON
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __JSON_H__
+#define __JSON_H__ 1
+
+#include <Arduino.h>
+#include "writer.h"
+
+/*
+   max. nesting of objects and arrays
+*/
+#define JSON_DEPTH_MAX    8
+
+/*
+   the serializer context
+
+   the values are written straight into the writer, so nothing is
+   buffered or allocated -- the names must not need escaping
+*/
+typedef struct _json {
+  WRITER *writer;
+  int depth;
+  bool members[JSON_DEPTH_MAX];   // a member was written on the level
+} JSON;
+
+/*
+   start and finish a JSON document -- the document is an object
+*/
+void JsonBegin(JSON *json, WRITER *writer);
+void JsonEnd(JSON *json);
+
+/*
+   start and finish a nested object or array -- the name is NULL inside arrays
+*/
+void JsonObjectBegin(JSON *json, const char *name);
+void JsonObjectEnd(JSON *json);
+void JsonArrayBegin(JSON *json, const char *name);
+void JsonArrayEnd(JSON *json);
+
+/*
+   write a member -- the name is NULL inside arrays
+*/
+void JsonString(JSON *json, const char *name, const char *value);
+void JsonInt(JSON *json, const char *name, long value);
+void JsonUnsigned(JSON *json, const char *name, unsigned long value);
+void JsonBool(JSON *json, const char *name, bool value);
+void JsonNull(JSON *json, const char *name);
+
+/*
+   the types of the parsed values
+*/
+enum JSON_TYPE {
+  JSON_TYPE_STRING = 0,
+  JSON_TYPE_NUMBER,
+  JSON_TYPE_TRUE,
+  JSON_TYPE_FALSE,
+  JSON_TYPE_NULL,
+};
+
+/*
+   the parser context
+
+   the parser walks a flat object in place -- strings are unescaped in
+   the text and all values are terminated there, so the text is modified
+*/
+typedef struct _json_parser {
+  char *next;
+  char delimiter;   // the delimiter behind the last value, which was overwritten
+} JSON_PARSER;
+
+/*
+   start parsing the given text -- it has to be terminated
+*/
+void JsonParseBegin(JSON_PARSER *parser, char *text);
+
+/*
+   get the next member of the object
+
+   returns 1 for a member, 0 at the end of the object and -1 for text
+   which is not a flat object -- nested objects and arrays are rejected
+*/
+int JsonParseMember(JSON_PARSER *parser, char **name, char **value, int *type);
+
+#endif
+
+/**/
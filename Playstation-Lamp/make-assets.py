@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+#
+#  Playstation-Lamp
+#
+#  (c) 2020 Christian.Lorenz@gromeck.de
+#
+#  minify and compress the static web assets into assets.h
+#
+#  usage: make-assets.py [<sketch dir>]
+#
+#  each file in <sketch dir>/assets is minified, compressed with gzip and
+#  embedded as a byte array together with its content type and a hash of
+#  its content -- the hash is used as the ETag and in the URLs of the
+#  assets, so they can be cached forever
+#
+#  run it whenever an asset was changed, or add it as a prebuild hook like
+#  make-git-version.sh:
+#
+#  recipe.hooks.sketch.prebuild.2.pattern=python3 {build.source.path}/make-assets.py "{build.source.path}"
+#
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+TYPES = {
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".html": "text/html",
+    ".svg": "image/svg+xml",
+}
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    text = text.replace(";}", "}")
+    return text.strip()
+
+
+def minify_js(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    return "\n".join(line.strip() for line in text.splitlines() if line.strip())
+
+
+def minify(name, text):
+    if name.endswith(".css"):
+        return minify_css(text)
+    if name.endswith(".js"):
+        return minify_js(text)
+    return text.strip()
+
+
+def identifier(name):
+    return re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def main():
+    sketch = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    source = os.path.join(sketch, "assets")
+    assets = []
+
+    for name in sorted(os.listdir(source)):
+        ext = os.path.splitext(name)[1]
+        if ext not in TYPES:
+            continue
+        with open(os.path.join(source, name)) as f:
+            data = minify(name, f.read()).encode()
+        compressed = gzip.compress(data, 9, mtime=0)
+        digest = hashlib.sha256(data).hexdigest()[:16]
+        assets.append((name, TYPES[ext], digest, compressed))
+        print("%s: %d bytes, %d bytes compressed" % (name, len(data), len(compressed)))
+
+    out = [
+        "/*",
+        "  Playstation-Lamp",
+        "",
+        "  the static web assets -- generated by make-assets.py, don't edit",
+        "*/",
+        "",
+        "#ifndef __ASSETS_H__",
+        "#define __ASSETS_H__ 1",
+        "",
+        "#include <stdint.h>",
+        "",
+    ]
+    for name, type, digest, data in assets:
+        ident = identifier(name)
+        out.append("#define ASSET_%s_HASH  \"%s\"" % (ident, digest))
+    out.append("")
+    out += [
+        "typedef struct _asset {",
+        "  const char *path;",
+        "  const char *type;",
+        "  const char *etag;",
+        "  const uint8_t *data;   // compressed with gzip",
+        "  int len;",
+        "} ASSET;",
+        "",
+    ]
+    for name, type, digest, data in assets:
+        out.append("static const uint8_t _asset_%s[] = {" % identifier(name).lower())
+        for n in range(0, len(data), 16):
+            out.append("  " + " ".join("0x%02x," % b for b in data[n:n + 16]))
+        out.append("};")
+        out.append("")
+    out.append("static const ASSET _assets[] = {")
+    for name, type, digest, data in assets:
+        out.append("  { \"/%s\", \"%s\", \"\\\"%s\\\"\", _asset_%s, sizeof(_asset_%s) }," %
+                   (name, type, digest, identifier(name).lower(), identifier(name).lower()))
+    out += [
+        "};",
+        "",
+        "#endif",
+        "",
+        "/**/",
+        "",
+    ]
+
+    target = os.path.join(sketch, "assets.h")
+    text = "\n".join(out)
+    if os.path.exists(target) and open(target).read() == text:
+        return
+    with open(target, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
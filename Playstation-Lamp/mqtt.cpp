@@ -26,9 +26,18 @@
 #include "config.h"
 #include "aoxa.h"
 #include "mqtt.h"
+#include "event.h"
+#if FEATURE_RULES
+#include "rules.h"
+#endif
+#if FEATURE_SCHEDULE
+#include "schedule.h"
+#endif
 #include "wifi.h"
 #include "util.h"
 
+#if FEATURE_MQTT
+
 /*
    MQTT context
 */
@@ -37,51 +46,218 @@ String _mqtt_topic_tele;
 String _mqtt_topic_cmnd;
 String _mqtt_topic_stat;
 static unsigned long _mqtt_reconnect_wait = 0;
+static bool _mqtt_connected = false;
+static bool _mqtt_ever_connected = false;
+static String _mqtt_topic_cmnd_prefix;
+static String _mqtt_topic_stat_brightness;
+static String _mqtt_topic_stat_config;
+static CONFIG_MQTT _config_mqtt;
 
 /*
-   this handler is called whenever we receive MQTT commands
+   command to change the AOXA mode
 */
-static void mqtt_handler(char* topic, uint8_t* data, unsigned int len)
+static void mqtt_cmnd_state(const char *data, unsigned int len)
 {
-  LogMsg("MQTT: handler received: topic:%s  data:%p  len:%d", topic, data, len);
-  dump("MQTT: handler", data, len);
-
   /*
      lets see if one mode matches
   */
   for (int aoxa_mode = AOXA_MODE_FIRST; aoxa_mode <= AOXA_MODE_LAST; aoxa_mode++)
-    if (!strncasecmp((const char *) data, AoxaLookupMode(aoxa_mode), len))
+    if (!strncasecmp(data, AoxaLookupMode(aoxa_mode), len))
       AoxaChangeMode(aoxa_mode);
+}
 
+/*
+   command to change the brightness
+*/
+static void mqtt_cmnd_brightness(const char *data, unsigned int len)
+{
+  char value[8];
+
+  len = min(len, (unsigned int) sizeof(value) - 1);
+  memcpy(value, data, len);
+  value[len] = '\0';
+  AoxaSetBrightness(atoi(value));
 }
 
 /*
-   initialize the MQTT context
+   command to recall a preset -- the payload is <n>, or save <n> to store
+   the current look as preset
 */
-void MqttSetup(void)
+static void mqtt_cmnd_preset(const char *data, unsigned int len)
 {
-  /*
-     check and correct the config
-  */
-  if (!_config.mqtt.port)
-    _config.mqtt.port = MQTT_PORT_DEFAULT;
-  _config.mqtt.port = min(max(_config.mqtt.port, MQTT_PORT_MIN), MQTT_PORT_MAX);
+  char value[16];
 
-  if (StateCheck(STATE_CONFIGURING))
+  len = min(len, (unsigned int) sizeof(value) - 1);
+  memcpy(value, data, len);
+  value[len] = '\0';
+  if (!strncasecmp(value, "save ", 5))
+    AoxaSavePreset(atoi(value + 5));
+  else
+    AoxaRecallPreset(atoi(value));
+}
+
+#if FEATURE_RULES
+/*
+   command to set new rules
+*/
+static void mqtt_cmnd_rules(const char *data, unsigned int len)
+{
+  RulesSet(data, len);
+}
+#endif
+
+#if FEATURE_SCHEDULE
+/*
+   command to set a new schedule
+*/
+static void mqtt_cmnd_schedule(const char *data, unsigned int len)
+{
+  ScheduleSet(data, len);
+}
+#endif
+
+/*
+   command to get or set a config field -- the payload is <name>=<value>
+   to set the field or <name> to get it reported
+*/
+static void mqtt_cmnd_config(const char *data, unsigned int len)
+{
+  char name[32];
+  char value[128];
+  const char *equal = (const char *) memchr(data, '=', len);
+  unsigned int name_len = equal ? equal - data : len;
+  const CONFIG_FIELD *field;
+
+  name_len = min(name_len, (unsigned int) sizeof(name) - 1);
+  memcpy(name, data, name_len);
+  name[name_len] = '\0';
+  if (!(field = ConfigLookupField(name))) {
+    LogMsg("MQTT: unknown config field %s", name);
     return;
+  }
 
-  LogMsg("MQTT: setting up context");
+  if (equal)
+    ConfigSetField(field, equal + 1, len - (equal + 1 - data));
+  else if (!(field->flags & CONFIG_FIELD_SECRET) && ConfigGetField(field, value, sizeof(value)))
+    MqttPublish(_mqtt_topic_stat_config.c_str(), (String(name) + "=" + value).c_str());
+}
 
-  _mqtt = new PubSubClient(_wifiClient);
-  _mqtt->setServer(_config.mqtt.server, _config.mqtt.port);
+/*
+   the commands we subscribe to -- the topic is MQTT_TOPIC_CMND/<prefix>/<name>
+*/
+static const struct {
+  const char *name;
+  void (*handler)(const char *data, unsigned int len);
+} _mqtt_commands[] = {
+  { "state", mqtt_cmnd_state },
+  { "brightness", mqtt_cmnd_brightness },
+  { "preset", mqtt_cmnd_preset },
+#if FEATURE_RULES
+  { "rules", mqtt_cmnd_rules },
+#endif
+#if FEATURE_SCHEDULE
+  { "schedule", mqtt_cmnd_schedule },
+#endif
+  { "config", mqtt_cmnd_config },
+};
 
-  _mqtt_topic_tele = MQTT_TOPIC_TELE "/" + String(_config.mqtt.topicPrefix);
-  _mqtt_topic_cmnd = MQTT_TOPIC_CMND "/" + String(_config.mqtt.topicPrefix) + "/state";
-  _mqtt_topic_stat = MQTT_TOPIC_STAT "/" + String(_config.mqtt.topicPrefix) + "/state";
+/*
+   this handler is called whenever we receive MQTT commands
+*/
+static void mqtt_handler(char* topic, uint8_t* data, unsigned int len)
+{
+  LogMsg("MQTT: handler received: topic:%s  data:%p  len:%d", topic, data, len);
+  dump("MQTT: handler", data, len);
+
+  if (strncmp(topic, _mqtt_topic_cmnd_prefix.c_str(), _mqtt_topic_cmnd_prefix.length()))
+    return;
+  topic += _mqtt_topic_cmnd_prefix.length();
+
+  for (unsigned int n = 0; n < sizeof(_mqtt_commands) / sizeof(_mqtt_commands[0]); n++)
+    if (!strcmp(topic, _mqtt_commands[n].name))
+      _mqtt_commands[n].handler((const char *) data, len);
+}
+
+/*
+   take over the config into the MQTT context
+*/
+static void mqtt_apply_config(const CONFIG_MQTT *config_mqtt)
+{
+  _config_mqtt = *config_mqtt;
+  _mqtt->setServer(_config_mqtt.server, _config_mqtt.port);
+
+  _mqtt_topic_tele = MQTT_TOPIC_TELE "/" + String(_config_mqtt.topicPrefix);
+  _mqtt_topic_cmnd_prefix = MQTT_TOPIC_CMND "/" + String(_config_mqtt.topicPrefix) + "/";
+  _mqtt_topic_cmnd = _mqtt_topic_cmnd_prefix + "state";
+  _mqtt_topic_stat = MQTT_TOPIC_STAT "/" + String(_config_mqtt.topicPrefix) + "/state";
+  _mqtt_topic_stat_brightness = MQTT_TOPIC_STAT "/" + String(_config_mqtt.topicPrefix) + "/brightness";
+  _mqtt_topic_stat_config = MQTT_TOPIC_STAT "/" + String(_config_mqtt.topicPrefix) + "/config";
 
   DbgMsg("MQTT: _mqtt_topic_stat: %s", _mqtt_topic_stat.c_str());
   DbgMsg("MQTT: _mqtt_topic_cmnd: %s", _mqtt_topic_cmnd.c_str());
   DbgMsg("MQTT: _mqtt_topic_tele: %s", _mqtt_topic_tele.c_str());
+}
+
+/*
+   get the config and check and correct it
+*/
+static void mqtt_get_config(CONFIG_MQTT *config_mqtt)
+{
+  CONFIG_GET(MQTT, mqtt, config_mqtt);
+  if (!config_mqtt->port)
+    config_mqtt->port = MQTT_PORT_DEFAULT;
+  config_mqtt->port = min(max(config_mqtt->port, MQTT_PORT_MIN), MQTT_PORT_MAX);
+}
+
+/*
+   this handler is called whenever an event we subscribed to is delivered
+*/
+static void mqtt_event_handler(const EVENT *event)
+{
+  switch (event->type) {
+    case EVENT_AOXA_MODE:
+      MqttPublishStat(String(AoxaLookupMode(event->arg)));
+      break;
+    case EVENT_AOXA_BRIGHTNESS:
+      MqttPublish(_mqtt_topic_stat_brightness.c_str(), String(event->arg).c_str());
+      break;
+    case EVENT_CONFIG:
+      if (CONFIG_COVERS(event->arg, event->arg2, MQTT, mqtt)) {
+        CONFIG_MQTT config_mqtt;
+
+        mqtt_get_config(&config_mqtt);
+        if (memcmp(&config_mqtt, &_config_mqtt, sizeof(CONFIG_MQTT))) {
+          /*
+             the settings changed -- reconnect with the new ones
+          */
+          LogMsg("MQTT: settings changed -- reconnecting");
+          if (_mqtt->connected())
+            _mqtt->disconnect();
+          mqtt_apply_config(&config_mqtt);
+          _mqtt_reconnect_wait = 0;
+        }
+      }
+      break;
+  }
+}
+
+/*
+   initialize the MQTT context
+*/
+void MqttSetup(void)
+{
+  CONFIG_MQTT config_mqtt;
+
+  if (StateCheck(STATE_CONFIGURING))
+    return;
+
+  EventSubscribe("mqtt", EVENT_MASK(EVENT_AOXA_MODE) | EVENT_MASK(EVENT_AOXA_BRIGHTNESS) | EVENT_MASK(EVENT_CONFIG), mqtt_event_handler);
+
+  LogMsg("MQTT: setting up context");
+
+  _mqtt = new PubSubClient(_wifiClient);
+  mqtt_get_config(&config_mqtt);
+  mqtt_apply_config(&config_mqtt);
 
   LogMsg("MQTT: context ready");
 }
@@ -91,19 +267,24 @@ void MqttSetup(void)
 */
 void MqttUpdate(void)
 {
-  if (StateCheck(STATE_CONFIGURING))
+  if (StateCheck(STATE_CONFIGURING) || !WifiConnected())
     return;
 
   if (!_mqtt->connected()) {
+    if (_mqtt_connected) {
+      LogMsg("MQTT: connection lost");
+      _mqtt_connected = false;
+      EventPublish(EVENT_MQTT, false);
+    }
     if (millis() > _mqtt_reconnect_wait) {
       /*
          connect the MQTT server
       */
-      LogMsg("MQTT: reconnecting %s:%s@%s:%d width clientID %s ...", _config.mqtt.user, _config.mqtt.password, _config.mqtt.server, _config.mqtt.port, _config.mqtt.clientID);
+      LogMsg("MQTT: reconnecting %s:%s@%s:%d width clientID %s ...", _config_mqtt.user, _config_mqtt.password, _config_mqtt.server, _config_mqtt.port, _config_mqtt.clientID);
       bool connect_status = _mqtt->connect(
-                              _config.mqtt.clientID,
-                              _config.mqtt.user,
-                              _config.mqtt.password,
+                              _config_mqtt.clientID,
+                              _config_mqtt.user,
+                              _config_mqtt.password,
                               _mqtt_topic_stat.c_str(),
                               2,  // willQoS
                               true,  // willRetain
@@ -118,15 +299,23 @@ void MqttUpdate(void)
         */
         DbgMsg("MQTT: publishing telemetry");
         _mqtt->publish((_mqtt_topic_tele + "/state").c_str(), "connected", true);
-        _mqtt->publish((_mqtt_topic_tele + "/Wifi_SSId").c_str(), WifiGetSSID().c_str(), true);
-        _mqtt->publish((_mqtt_topic_tele + "/IPAddress").c_str(), WifiGetIpAddr().c_str(), true);
+        _mqtt->publish((_mqtt_topic_tele + "/Wifi_SSId").c_str(), WifiGetSSID(), true);
+        _mqtt->publish((_mqtt_topic_tele + "/IPAddress").c_str(), WifiGetIpAddr(), true);
         _mqtt->publish((_mqtt_topic_tele + "/Version").c_str(),GIT_VERSION, true);
+        MqttPublishStat(String(AoxaLookupMode(AoxaGetMode())));
+        _mqtt->publish(_mqtt_topic_stat_brightness.c_str(), String(AoxaGetBrightness()).c_str());
 
         // ... and resubscribe
-        _mqtt->subscribe(_mqtt_topic_cmnd.c_str());
+        for (unsigned int n = 0; n < sizeof(_mqtt_commands) / sizeof(_mqtt_commands[0]); n++)
+          _mqtt->subscribe((_mqtt_topic_cmnd_prefix + _mqtt_commands[n].name).c_str());
 
         // install the handler for subscribed topics
         _mqtt->setCallback(mqtt_handler);
+
+        if (!_mqtt_ever_connected)
+          BootPhase("mqtt");
+        _mqtt_connected = _mqtt_ever_connected = true;
+        EventPublish(EVENT_MQTT, true);
       }
       else {
         /*
@@ -141,6 +330,14 @@ void MqttUpdate(void)
     _mqtt->loop();
 }
 
+/*
+   check if the client is connected to the broker
+*/
+bool MqttConnected(void)
+{
+  return _mqtt_connected;
+}
+
 /*
    publish the given message
 */
@@ -151,4 +348,19 @@ void MqttPublishStat(String msg)
 
   if (_mqtt)
     _mqtt->publish(_mqtt_topic_stat.c_str(), msg.c_str(), msg.length());
-}/**/
+}
+
+/*
+   publish the given message to the given topic
+*/
+void MqttPublish(const char *topic, const char *msg)
+{
+  DbgMsg("MQTT: publishing: %s=%s", topic, msg);
+
+  if (_mqtt)
+    _mqtt->publish(topic, msg);
+}
+
+#endif
+
+/**/
@@ -59,11 +59,21 @@ void MqttSetup(void);
 */
 void MqttUpdate(void);
 
+/*
+   check if the client is connected to the broker
+*/
+bool MqttConnected(void);
+
 /*
    publish the given message
 */
 void MqttPublishStat(String msg);
 
+/*
+   publish the given message to the given topic
+*/
+void MqttPublish(const char *topic, const char *msg);
+
 #endif
 
 /**/
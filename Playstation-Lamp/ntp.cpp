@@ -23,10 +23,14 @@
 
 */
 
+#include <lwip/dns.h>
 #include "config.h"
 #include "ntp.h"
+#include "event.h"
 #include "util.h"
 
+#if FEATURE_NTP
+
 /*
    NTP configuration
 */
@@ -47,6 +51,11 @@ static CONFIG_NTP _config_ntp;
 */
 #define NTP_SYNC_INTERVAL  (60 * 5)
 
+/*
+**  if the lookup of the NTP server failed, wait this time before retrying
+*/
+#define NTP_RESOLVE_RETRY  10
+
 /*
 **  NTP time stamp is in the first 48 bytes of the message
 */
@@ -64,6 +73,22 @@ static String _ntp_server = "";
 static IPAddress _ntp_ip(0, 0, 0, 0);
 static int _ntp_sync_cycle = 0;
 static time_t _up_since = 0;
+static unsigned long _ntp_resolve_wait = 0;
+
+/*
+   the lookup of the server runs in the background -- the answer is passed
+   from the callback of the network stack to NtpUpdate()
+*/
+enum NTP_RESOLVE {
+  NTP_RESOLVE_IDLE = 0,
+  NTP_RESOLVE_RUNNING,
+  NTP_RESOLVE_DONE,
+  NTP_RESOLVE_FAILED,
+};
+
+static volatile int _ntp_resolve_state = NTP_RESOLVE_IDLE;
+static volatile uint32_t _ntp_resolve_addr = 0;
+static uint32_t _ntp_resolve_id = 0;    // identifies the running lookup
 
 /*
 **  UDP instance to let us send and receive packets
@@ -154,14 +179,100 @@ static void NtpInit()
   }
 }
 
+/*
+   the answer of the lookup -- called by the network stack in its own task,
+   the answer of a lookup for a former server is dropped
+*/
+static void ntp_resolve_found(const char *name, const ip_addr_t *addr, void *arg)
+{
+  if ((uint32_t) (uintptr_t) arg != _ntp_resolve_id)
+    return;
+  if (addr) {
+    _ntp_resolve_addr = ip4_addr_get_u32(ip_2_ip4(addr));
+    _ntp_resolve_state = NTP_RESOLVE_DONE;
+  }
+  else
+    _ntp_resolve_state = NTP_RESOLVE_FAILED;
+}
+
+/*
+   look up the ntpservers ip and initialize ntp
+
+   the lookup is started and its answer is taken in later calls, so the
+   loop never waits for the DNS
+*/
+static void NtpResolve(void)
+{
+  ip_addr_t addr;
+  err_t err;
+
+  switch (_ntp_resolve_state) {
+    case NTP_RESOLVE_IDLE:
+      _ntp_resolve_state = NTP_RESOLVE_RUNNING;
+      err = dns_gethostbyname(_config_ntp.server, &addr, ntp_resolve_found, (void *) (uintptr_t) ++_ntp_resolve_id);
+      if (err == ERR_OK) {
+        /*
+           the address was given or is cached
+        */
+        _ntp_resolve_addr = ip4_addr_get_u32(ip_2_ip4(&addr));
+        _ntp_resolve_state = NTP_RESOLVE_DONE;
+      }
+      else if (err != ERR_INPROGRESS)
+        _ntp_resolve_state = NTP_RESOLVE_FAILED;
+      return;
+    case NTP_RESOLVE_RUNNING:
+      return;
+    case NTP_RESOLVE_FAILED:
+      LogMsg("NTP: lookup of %s failed -- trying again in %d seconds", _config_ntp.server, NTP_RESOLVE_RETRY);
+      _ntp_resolve_wait = millis() + NTP_RESOLVE_RETRY * 1000;
+      _ntp_resolve_state = NTP_RESOLVE_IDLE;
+      return;
+  }
+
+  _ntp_ip = IPAddress(_ntp_resolve_addr);
+  _ntp_resolve_state = NTP_RESOLVE_IDLE;
+  LogMsg("NTP: lookup of %s successful: %s", _config_ntp.server, IPAddressToString(_ntp_ip).c_str());
+
+  NtpInit();
+}
+
+/*
+   this handler is called whenever the config was changed
+*/
+static void ntp_event_handler(const EVENT *event)
+{
+  CONFIG_NTP config_ntp;
+
+  if (!CONFIG_COVERS(event->arg, event->arg2, NTP, ntp))
+    return;
+
+  CONFIG_GET(NTP, ntp, &config_ntp);
+  if (!strcmp(config_ntp.server, _config_ntp.server))
+    return;
+
+  /*
+     the server changed -- it will be resolved again in NtpUpdate()
+  */
+  LogMsg("NTP: server changed to %s", config_ntp.server);
+  _config_ntp = config_ntp;
+  _ntp_ip = IPAddress(0, 0, 0, 0);
+  _ntp_resolve_wait = 0;
+  _ntp_resolve_id++;
+  _ntp_resolve_state = NTP_RESOLVE_IDLE;
+}
+
 /*
 **	init the ntp functionality
+
+    the server is resolved in NtpUpdate() as soon as the WiFi is connected
 */
 void NtpSetup(void)
 {
   if (StateCheck(STATE_CONFIGURING))
     return;
 
+  EventSubscribe("ntp", EVENT_MASK(EVENT_CONFIG), ntp_event_handler);
+
   CONFIG_GET(NTP, ntp, &_config_ntp);
   if (!_config_ntp.server[0]) {
     LogMsg("NTP: no server configured");
@@ -174,24 +285,6 @@ void NtpSetup(void)
      get the NTP from the configuration
   */
   LogMsg("NTP: server=%s", _config_ntp.server);
-
-  /*
-     look up the ntpservers ip
-  */
-  if (WiFi.hostByName(_config_ntp.server, _ntp_ip)) {
-    /*
-       we could resolve the ntp name, so store it in the flash
-    */
-    LogMsg("NTP: lookup of %s successful: %s", _config_ntp.server, IPAddressToString(_ntp_ip).c_str());
-  }
-  else {
-    LogMsg("NTP: lookup of %s failed", _config_ntp.server);
-    return;
-  }
-
-  DbgMsg("NTP: ip=%s", IPAddressToString(_ntp_ip).c_str());
-
-  NtpInit();
 }
 
 /*
@@ -202,6 +295,15 @@ void NtpUpdate(void)
   if (StateCheck(STATE_CONFIGURING))
     return;
 
+  if (!_ntp_ip[0]) {
+    /*
+       resolve the server once we are connected
+    */
+    if (_config_ntp.server[0] && WifiConnected() && (_ntp_resolve_state != NTP_RESOLVE_IDLE || millis() > _ntp_resolve_wait))
+      NtpResolve();
+    return;
+  }
+
   if (++_ntp_sync_cycle >= NTPSYNC_CYCLES && timeStatus() != timeSet) {
     _ntp_sync_cycle = 0;
     NtpInit();
@@ -214,4 +316,8 @@ void NtpUpdate(void)
 time_t NtpUpSince(void)
 {
   return _up_since;
-}/**/
+}
+
+#endif
+
+/**/
@@ -0,0 +1,169 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to update the firmware over HTTP
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include "config.h"
+#include "ota.h"
+#include "http.h"
+#include "state.h"
+#include "wifi.h"
+
+#if FEATURE_OTA
+
+/*
+   the running firmware waits for its verification
+*/
+static bool _ota_pending = false;
+
+/*
+   an upload is running
+*/
+static bool _ota_running = false;
+
+/*
+   the running firmware is verified by OtaUpdate(), not right at the start
+*/
+extern "C" bool verifyRollbackLater(void)
+{
+  return true;
+}
+
+/*
+   answer the upload
+*/
+static void ota_answer(WiFiClient *client, WRITER *w, int code, const char *text)
+{
+  WriterBegin(w, client, code, "text/plain");
+  WriterBody(w, strlen(text));
+  WriterPrint(w, text);
+  WriterEnd(w);
+}
+
+/*
+   take a piece of the image -- it goes right into the inactive partition
+*/
+static bool ota_stream(WiFiClient *client, WRITER *w, const uint8_t *data, int len)
+{
+  if (len < 0) {
+    LogMsg("OTA: upload broke off after %u bytes", Update.progress());
+    Update.abort();
+    _ota_running = false;
+    return false;
+  }
+
+  if (data) {
+    if ((int) Update.write((uint8_t *) data, len) == len)
+      return true;
+    LogMsg("OTA: writing the image failed: %s", Update.errorString());
+    ota_answer(client, w, 500, Update.errorString());
+    Update.abort();
+    _ota_running = false;
+    return false;
+  }
+
+  /*
+     the image is complete -- its MD5 is checked and it is set to be booted
+  */
+  _ota_running = false;
+  if (!Update.end()) {
+    LogMsg("OTA: finishing the update failed: %s", Update.errorString());
+    ota_answer(client, w, 400, Update.errorString());
+    return false;
+  }
+  LogMsg("OTA: update of %u bytes done, restarting", Update.size());
+  ota_answer(client, w, 200, "Update done, restarting");
+  StateChange(STATE_WAIT_BEFORE_REBOOTING);
+  return true;
+}
+
+/*
+   setup the firmware update
+*/
+void OtaSetup(void)
+{
+  esp_ota_img_states_t state;
+
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+    LogMsg("OTA: running a new firmware, waiting for its verification");
+    _ota_pending = true;
+  }
+}
+
+/*
+   cyclic update -- verify a new firmware
+*/
+void OtaUpdate(void)
+{
+  if (!_ota_pending)
+    return;
+
+  if (StateCheck(STATE_OPERATION) && WifiConnected() && millis() > OTA_VERIFY_DELAY) {
+    LogMsg("OTA: new firmware is up and running, marking it as valid");
+    esp_ota_mark_app_valid_cancel_rollback();
+    _ota_pending = false;
+  }
+  else if (millis() > OTA_VERIFY_TIMEOUT) {
+    LogMsg("OTA: new firmware didn't come up, rolling back");
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+  }
+}
+
+/*
+   start an upload
+*/
+void OtaUpload(SERVER_REQUEST *request, WRITER *w)
+{
+  const char *md5 = ServerArg(request, "md5");
+
+  /*
+     without a password anyone in the network could flash the lamp
+  */
+  if (!_config.device.password[0])
+    return ServerError(request, w, 403, "Set a device password to enable the firmware update");
+  if (!HttpAuthorized(request, w, true))
+    return;
+  if (request->method != SERVER_METHOD_PUT && request->method != SERVER_METHOD_POST)
+    return ServerError(request, w, 400, "PUT or POST the image");
+  if (!md5 || strlen(md5) != 32)
+    return ServerError(request, w, 400, "MD5 of the image is missing");
+  if (request->body_len <= 0)
+    return ServerError(request, w, 400, "Image is missing");
+  if (_ota_running || _ota_pending)
+    return ServerError(request, w, 503, "Update is not possible now");
+
+  if (!Update.begin(request->body_len, U_FLASH)) {
+    LogMsg("OTA: starting the update failed: %s", Update.errorString());
+    return ServerError(request, w, 413, Update.errorString());
+  }
+  Update.setMD5(md5);
+  LogMsg("OTA: receiving an image of %d bytes", request->body_len);
+  _ota_running = true;
+  request->stream = ota_stream;
+}
+
+#endif
+
+/**/
@@ -0,0 +1,67 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to update the firmware over HTTP
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __OTA_H__
+#define __OTA_H__ 1
+
+#include "config.h"
+#include "server.h"
+
+/*
+   the path of the upload -- the image is PUT or POSTed as the body,
+   with its MD5 as the argument md5
+*/
+#define OTA_PATH              "/update"
+
+/*
+   a new firmware is marked as valid once it is in STATE_OPERATION with
+   the WiFi connected for this time after the boot [ms]
+*/
+#define OTA_VERIFY_DELAY      (60 * 1000)
+
+/*
+   a new firmware which isn't valid after this time is rolled back [ms]
+*/
+#define OTA_VERIFY_TIMEOUT    (10 * 60 * 1000)
+
+/*
+   setup the firmware update -- checks if the running firmware is new
+*/
+void OtaSetup(void);
+
+/*
+   cyclic update -- marks a new firmware as valid, or rolls it back
+*/
+void OtaUpdate(void);
+
+/*
+   the handler of OTA_PATH -- uploads are refused while no device
+   password is set
+*/
+void OtaUpload(SERVER_REQUEST *request, WRITER *w);
+
+#endif
+
+/**/
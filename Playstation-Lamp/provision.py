@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+#  Playstation-Lamp
+#
+#  (c) 2020 Christian.Lorenz@gromeck.de
+#
+#  provision a lamp with a whole config via the serial port
+#
+#  usage: provision.py <port> <config file>
+#
+#  the config file holds one <name>=<value> per line, the names are the
+#  ones used by the CLI and the configuration forms -- fields which are
+#  not given are cleared
+#
+#  the fields are taken from the firmware with the CLI command fields, and
+#  the frame is sent in blocks, each acknowledged by the lamp
+#
+#  requires pyserial
+#
+
+import struct
+import sys
+import zlib
+
+import serial
+
+FRAME_START = 0x02
+FRAME_BLOCK = 128   # CLI_FRAME_BLOCK in cli.h
+
+
+def answer(port, expect):
+    """read lines up to the answer, the log messages in between are skipped"""
+    lines = []
+    while True:
+        line = port.readline().decode(errors="replace").strip()
+        if not line:
+            sys.exit("no answer from the device")
+        if line.startswith("ERR"):
+            sys.exit(line)
+        if line.startswith(expect):
+            return lines
+        lines.append(line)
+
+
+def fields(port):
+    """get the field table of the firmware -- name: (tag, type, size)"""
+    port.write(b"fields\n")
+    table = {}
+    for line in answer(port, "OK"):
+        words = line.split()
+        if len(words) == 5 and words[0] == "FIELD":
+            table[words[1]] = (int(words[2]), words[3], int(words[4]))
+    return table
+
+
+def encode(config, table):
+    data = b""
+    for name, value in config.items():
+        if name not in table:
+            sys.exit("unknown field %s" % name)
+        tag, type, size = table[name]
+        if type == "int":
+            value = struct.pack("<i", int(value))
+        elif type == "string":
+            value = value.encode()
+            if len(value) >= size:
+                sys.exit("value of %s is too long" % name)
+        else:
+            sys.exit("field %s can't be set from text" % name)
+        data += struct.pack("<BH", tag, len(value)) + value
+    return data
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: %s <port> <config file>" % sys.argv[0])
+
+    config = {}
+    with open(sys.argv[2]) as f:
+        for line in f:
+            line = line.strip()
+            if line and not line.startswith("#"):
+                name, value = line.split("=", 1)
+                config[name.strip()] = value.strip()
+
+    with serial.Serial(sys.argv[1], 115200, timeout=5) as port:
+        port.reset_input_buffer()
+        data = encode(config, fields(port))
+        body = data + struct.pack("<I", zlib.crc32(data))
+        port.write(struct.pack("<BH", FRAME_START, len(data)))
+        for n in range(0, len(body), FRAME_BLOCK):
+            port.write(body[n:n + FRAME_BLOCK])
+            if n + FRAME_BLOCK < len(body):
+                answer(port, "NEXT")
+        answer(port, "OK")
+        port.write(b"restart\n")
+        print("provisioned")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,411 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the rules engine
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "rules.h"
+#include "event.h"
+#include "aoxa.h"
+#if FEATURE_MQTT
+#include "mqtt.h"
+#endif
+#include "util.h"
+
+#if FEATURE_RULES
+
+/*
+   wildcard for trigger arguments
+*/
+#define RULE_ARG_ANY    -128
+
+/*
+   conditions
+*/
+enum RULE_COND {
+  RULE_COND_NONE = 0,
+  RULE_COND_MODE_EQ,
+  RULE_COND_MODE_NE,
+};
+
+/*
+   actions
+*/
+enum RULE_ACTION {
+  RULE_ACTION_NONE = 0,
+  RULE_ACTION_MODE,
+  RULE_ACTION_NEXT,
+  RULE_ACTION_PUBLISH,
+  RULE_ACTION_PRESET,
+};
+
+/*
+   a compiled rule
+*/
+typedef struct {
+  uint8_t event;        // the event type which triggers the rule
+  int8_t arg;           // the event argument which has to match, or RULE_ARG_ANY
+  uint8_t cond;         // the condition
+  int8_t cond_arg;      // the argument of the condition
+  uint8_t action;       // the action
+  int16_t action_arg;   // the argument of the action, or the offset in the string pool
+} RULE;
+
+/*
+   the rule table, sorted by event type
+
+   the rules for an event type are _rules[_rules_index[type]] up to _rules[_rules_index[type + 1] - 1]
+*/
+static RULE _rules[RULES_MAX];
+static uint8_t _rules_index[EVENT_TYPES + 1];
+static int _rules_count = 0;
+
+/*
+   the string pool for the publish actions -- topic and payload, each terminated by a '\0'
+*/
+static char _rules_strings[sizeof(CONFIG_RULES)];
+
+/*
+   the last compile error
+*/
+static char _rules_error[64] = "";
+
+/*
+   the trigger names
+*/
+static const struct {
+  const char *source;
+  const char *name;
+  uint8_t event;
+  int8_t arg;
+} _rules_triggers[] = {
+  { "button", "press", EVENT_AOXA_BUTTON, AOXA_BUTTON_PRESS },
+  { "button", "longpress", EVENT_AOXA_BUTTON, AOXA_BUTTON_LONG_PRESS },
+  { "wifi", "connected", EVENT_WIFI, true },
+  { "wifi", "disconnected", EVENT_WIFI, false },
+#if FEATURE_MQTT
+  { "mqtt", "connected", EVENT_MQTT, true },
+  { "mqtt", "disconnected", EVENT_MQTT, false },
+#endif
+};
+
+/*
+   parse a mode name -- a missing name is invalid
+*/
+static bool rules_parse_mode(const char *name, int8_t *mode)
+{
+  int m;
+
+  if (!name)
+    return false;
+  m = AoxaParseMode(name, strlen(name));
+
+  if (m == AOXA_MODE_LAST_PLUS_ONE)
+    return false;
+  *mode = m;
+  return true;
+}
+
+/*
+   parse the trigger
+*/
+static bool rules_parse_trigger(char *trigger, RULE *rule)
+{
+  char *name = strchr(trigger, '#');
+
+  if (name)
+    *name++ = '\0';
+  rule->arg = RULE_ARG_ANY;
+
+  if (!strcasecmp(trigger, "mode")) {
+    rule->event = EVENT_AOXA_MODE;
+    return !name || rules_parse_mode(name, &rule->arg);
+  }
+  for (unsigned int n = 0; n < sizeof(_rules_triggers) / sizeof(_rules_triggers[0]); n++) {
+    if (!strcasecmp(trigger, _rules_triggers[n].source)) {
+      rule->event = _rules_triggers[n].event;
+      if (!name)
+        return true;
+      if (!strcasecmp(name, _rules_triggers[n].name)) {
+        rule->arg = _rules_triggers[n].arg;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*
+   parse the condition
+*/
+static bool rules_parse_condition(char *cond, RULE *rule)
+{
+  char *value;
+
+  if (!strncasecmp(cond, "mode!=", 6)) {
+    rule->cond = RULE_COND_MODE_NE;
+    value = cond + 6;
+  }
+  else if (!strncasecmp(cond, "mode=", 5)) {
+    rule->cond = RULE_COND_MODE_EQ;
+    value = cond + 5;
+  }
+  else
+    return false;
+  return rules_parse_mode(value, &rule->cond_arg);
+}
+
+/*
+   parse the action -- rest points to the remaining text of the statement
+*/
+static bool rules_parse_action(char *action, char *rest, RULE *rule, char *strings, int *pool)
+{
+  char *save = NULL;
+
+  if (!strcasecmp(action, "next")) {
+    rule->action = RULE_ACTION_NEXT;
+    return true;
+  }
+  if (!strcasecmp(action, "mode") && rest) {
+    char *arg = strtok_r(rest, " \t", &save);
+    int8_t mode;
+
+    rule->action = RULE_ACTION_MODE;
+    if (!arg || !rules_parse_mode(arg, &mode))
+      return false;
+    rule->action_arg = mode;
+    return true;
+  }
+  if (!strcasecmp(action, "preset") && rest) {
+    char *arg = strtok_r(rest, " \t", &save);
+    int preset = arg ? atoi(arg) : 0;
+
+    if (preset < 1 || preset > AOXA_PRESETS)
+      return false;
+    rule->action = RULE_ACTION_PRESET;
+    rule->action_arg = preset;
+    return true;
+  }
+#if FEATURE_MQTT
+  if (!strcasecmp(action, "publish") && rest) {
+    char *topic = strtok_r(rest, " \t", &save);
+    char *payload = topic ? strtok_r(NULL, "", &save) : NULL;
+    int len;
+
+    if (!topic)
+      return false;
+    if (!payload)
+      payload = (char *) "";
+    while (*payload == ' ' || *payload == '\t')
+      payload++;
+    if (*pool + (len = strlen(topic) + 1) + (int) strlen(payload) + 1 > (int) sizeof(_rules_strings))
+      return false;
+    rule->action = RULE_ACTION_PUBLISH;
+    rule->action_arg = *pool;
+    strcpy(&strings[*pool], topic);
+    strcpy(&strings[*pool + len], payload);
+    *pool += len + strlen(payload) + 1;
+    return true;
+  }
+#endif
+  return false;
+}
+
+/*
+   execute the action of a rule
+*/
+static void rules_execute(const RULE *rule)
+{
+  switch (rule->action) {
+    case RULE_ACTION_MODE:
+      AoxaChangeMode(rule->action_arg);
+      break;
+    case RULE_ACTION_NEXT:
+      AoxaNextMode();
+      break;
+    case RULE_ACTION_PRESET:
+      AoxaRecallPreset(rule->action_arg);
+      break;
+#if FEATURE_MQTT
+    case RULE_ACTION_PUBLISH:
+      {
+        const char *topic = &_rules_strings[rule->action_arg];
+
+        MqttPublish(topic, topic + strlen(topic) + 1);
+      }
+      break;
+#endif
+  }
+}
+
+/*
+   this handler is called whenever an event we subscribed to is delivered
+
+   only the rules for the event type are checked -- no parsing at this point
+*/
+static void rules_event_handler(const EVENT *event)
+{
+  if (event->type == EVENT_CONFIG) {
+    /*
+       recompile if the rules were changed
+    */
+    if (CONFIG_COVERS(event->arg, event->arg2, RULES, rules))
+      RulesCompile(_config.rules.text);
+    return;
+  }
+
+  for (int n = _rules_index[event->type]; n < _rules_index[event->type + 1]; n++) {
+    const RULE *rule = &_rules[n];
+
+    if (rule->arg != RULE_ARG_ANY && rule->arg != event->arg)
+      continue;
+    if (rule->cond == RULE_COND_MODE_EQ && AoxaGetMode() != rule->cond_arg)
+      continue;
+    if (rule->cond == RULE_COND_MODE_NE && AoxaGetMode() == rule->cond_arg)
+      continue;
+    DbgMsg("RULES: rule %d triggered by %s", n, EventLookupType(event->type));
+    rules_execute(rule);
+  }
+}
+
+/*
+   setup the rules engine
+*/
+void RulesSetup(void)
+{
+  LogMsg("RULES: setting up rules engine");
+
+  RulesCompile(_config.rules.text);
+
+  EventSubscribe("rules",
+                 EVENT_MASK(EVENT_AOXA_MODE) | EVENT_MASK(EVENT_AOXA_BUTTON) | EVENT_MASK(EVENT_WIFI) | EVENT_MASK(EVENT_MQTT) | EVENT_MASK(EVENT_CONFIG),
+                 rules_event_handler);
+}
+
+/*
+   compile the given rules text into the rule table
+
+   returns the number of compiled rules, or -1 on error
+*/
+int RulesCompile(const char *text)
+{
+  static char buffer[sizeof(CONFIG_RULES)];
+  static RULE rules[RULES_MAX];
+  static char strings[sizeof(_rules_strings)];
+  char *statement, *save_statement;
+  int count = 0, pool = 0, line = 0;
+
+  strncpy(buffer, text, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+  _rules_error[0] = '\0';
+
+  for (statement = strtok_r(buffer, ";\r\n", &save_statement); statement; statement = strtok_r(NULL, ";\r\n", &save_statement)) {
+    RULE rule;
+    char *token, *save_token;
+
+    line++;
+    memset(&rule, 0, sizeof(rule));
+    if (!(token = strtok_r(statement, " \t", &save_token)))
+      continue;
+    if (count >= RULES_MAX) {
+      snprintf(_rules_error, sizeof(_rules_error), "rule %d: too many rules", line);
+      break;
+    }
+    if (strcasecmp(token, "ON") || !(token = strtok_r(NULL, " \t", &save_token)) || !rules_parse_trigger(token, &rule)) {
+      snprintf(_rules_error, sizeof(_rules_error), "rule %d: bad trigger", line);
+      break;
+    }
+    if (!(token = strtok_r(NULL, " \t", &save_token))) {
+      snprintf(_rules_error, sizeof(_rules_error), "rule %d: missing DO", line);
+      break;
+    }
+    if (!strcasecmp(token, "IF")) {
+      if (!(token = strtok_r(NULL, " \t", &save_token)) || !rules_parse_condition(token, &rule)) {
+        snprintf(_rules_error, sizeof(_rules_error), "rule %d: bad condition", line);
+        break;
+      }
+      token = strtok_r(NULL, " \t", &save_token);
+    }
+    if (!token || strcasecmp(token, "DO") || !(token = strtok_r(NULL, " \t", &save_token))
+        || !rules_parse_action(token, strtok_r(NULL, "", &save_token), &rule, strings, &pool)) {
+      snprintf(_rules_error, sizeof(_rules_error), "rule %d: bad action", line);
+      break;
+    }
+    rules[count++] = rule;
+  }
+
+  if (_rules_error[0]) {
+    LogMsg("RULES: %s -- keeping the %d active rules", _rules_error, _rules_count);
+    return -1;
+  }
+
+  /*
+     sort the rules by their event type into the active table
+  */
+  _rules_count = 0;
+  for (int type = 0; type < EVENT_TYPES; type++) {
+    _rules_index[type] = _rules_count;
+    for (int n = 0; n < count; n++)
+      if (rules[n].event == type)
+        _rules[_rules_count++] = rules[n];
+  }
+  _rules_index[EVENT_TYPES] = _rules_count;
+  memcpy(_rules_strings, strings, pool);
+
+  LogMsg("RULES: %d rules compiled", _rules_count);
+  return _rules_count;
+}
+
+/*
+   set and store new rules
+*/
+void RulesSet(const char *text, int len)
+{
+  CONFIG_RULES rules;
+
+  memset(&rules, 0, sizeof(rules));
+  strncpy(rules.text, text, min(len, (int) sizeof(rules.text) - 1));
+  CONFIG_SET(CONFIG_RULES, rules, &rules);
+}
+
+/*
+   return the number of active rules
+*/
+int RulesCount(void)
+{
+  return _rules_count;
+}
+
+/*
+   return the last compile error, or an empty string
+*/
+const char *RulesError(void)
+{
+  return _rules_error;
+}
+
+#endif
+
+/**/
@@ -0,0 +1,94 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the rules engine
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __RULES_H__
+#define __RULES_H__ 1
+
+#include "config.h"
+
+/*
+   max. number of compiled rules
+*/
+#define RULES_MAX   16
+
+/*
+   the rules are given as text, one rule per line or separated by ';'
+
+      ON <trigger> [IF <condition>] DO <action>
+
+   triggers:
+
+      mode[#<MODE>]                   the AOXA mode changed (to the given mode)
+      button[#press|#longpress]       the button was pressed
+      wifi[#connected|#disconnected]  the WiFi connection changed
+      mqtt[#connected|#disconnected]  the MQTT connection changed
+
+   conditions:
+
+      mode=<MODE>, mode!=<MODE>       check the current AOXA mode
+
+   actions:
+
+      mode <MODE>                     switch to the given mode
+      next                            switch to the next mode
+      preset <n>                      recall the given preset
+      publish <topic> <payload>       publish the payload via MQTT
+
+   example:
+
+      ON mqtt#disconnected DO mode BLINK
+      ON button#longpress IF mode!=OFF DO publish cmnd/hall/light/state TOGGLE
+*/
+
+/*
+   setup the rules engine
+*/
+void RulesSetup(void);
+
+/*
+   compile the given rules text into the rule table
+
+   returns the number of compiled rules, or -1 on error
+*/
+int RulesCompile(const char *text);
+
+/*
+   set and store new rules
+*/
+void RulesSet(const char *text, int len);
+
+/*
+   return the number of active rules
+*/
+int RulesCount(void);
+
+/*
+   return the last compile error, or an empty string
+*/
+const char *RulesError(void);
+
+#endif
+
+/**/
@@ -0,0 +1,286 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the time-of-day mode scheduler
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "schedule.h"
+#include "event.h"
+#include "aoxa.h"
+#include "util.h"
+
+#if FEATURE_SCHEDULE
+
+#define SCHEDULE_DAYS_ALL     0x7f
+#define SCHEDULE_DAYS_WEEKEND 0x41
+#define SCHEDULE_DAYS_WEEKDAY 0x3e
+
+/*
+   the precomputed next event
+*/
+static time_t _schedule_next = 0;
+static int _schedule_next_entry = -1;
+
+/*
+   the day names -- index is the bit in the days mask
+*/
+static const char *_schedule_days[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+/*
+   compute the next time after t at which the given entry fires
+*/
+static time_t schedule_entry_next(const CONFIG_SCHEDULE_ENTRY *entry, time_t t)
+{
+  time_t midnight = (t / SECS_PER_DAY) * SECS_PER_DAY;
+
+  for (int day = 0; day <= 7; day++) {
+    time_t next = midnight + day * SECS_PER_DAY + entry->hour * SECS_PER_HOUR + entry->minute * SECS_PER_MIN;
+    int weekday = (next / SECS_PER_DAY + 4) % 7;  // 01.01.1970 was a thursday
+
+    if (next > t && (entry->days & (1 << weekday)))
+      return next;
+  }
+  return 0;
+}
+
+/*
+   precompute the next event out of all entries
+*/
+static void schedule_compute_next(void)
+{
+  time_t t = now();
+
+  _schedule_next = 0;
+  _schedule_next_entry = -1;
+
+  if (timeStatus() == timeNotSet)
+    return;
+
+  for (unsigned int n = 0; n < SCHEDULE_ENTRIES; n++) {
+    const CONFIG_SCHEDULE_ENTRY *entry = &_config.schedule.entries[n];
+    time_t next;
+
+    if (!entry->days)
+      continue;
+    if ((next = schedule_entry_next(entry, t)) && (!_schedule_next || next < _schedule_next)) {
+      _schedule_next = next;
+      _schedule_next_entry = n;
+    }
+  }
+
+  if (_schedule_next)
+    DbgMsg("SCHEDULE: next event at %s: entry %d", TimeToString(_schedule_next), _schedule_next_entry);
+}
+
+/*
+   this handler is called whenever an event we subscribed to is delivered
+*/
+static void schedule_event_handler(const EVENT *event)
+{
+  if (CONFIG_COVERS(event->arg, event->arg2, SCHEDULE, schedule))
+    schedule_compute_next();
+}
+
+/*
+   setup the scheduler
+*/
+void ScheduleSetup(void)
+{
+  LogMsg("SCHEDULE: setting up scheduler");
+
+  schedule_compute_next();
+  EventSubscribe("schedule", EVENT_MASK(EVENT_CONFIG), schedule_event_handler);
+}
+
+/*
+   cyclic update of the scheduler
+
+   the next event is precomputed, so this is a single comparison in the normal case
+*/
+void ScheduleUpdate(void)
+{
+  static bool time_set = false;
+
+  if (!_schedule_next) {
+    /*
+       nothing scheduled so far -- recompute once the time got set
+    */
+    if (!time_set && timeStatus() != timeNotSet) {
+      time_set = true;
+      schedule_compute_next();
+    }
+    return;
+  }
+
+  if (now() >= _schedule_next) {
+    const CONFIG_SCHEDULE_ENTRY *entry = &_config.schedule.entries[_schedule_next_entry];
+
+    LogMsg("SCHEDULE: entry %d fired: %02d:%02d %s", _schedule_next_entry, entry->hour, entry->minute, AoxaLookupMode(entry->mode));
+    AoxaChangeMode(entry->mode);
+    schedule_compute_next();
+  }
+}
+
+/*
+   parse the days of an entry
+*/
+static uint8_t schedule_parse_days(char *days)
+{
+  uint8_t mask = 0;
+  char *day, *save;
+
+  for (day = strtok_r(days, ",", &save); day; day = strtok_r(NULL, ",", &save)) {
+    if (!strcasecmp(day, "daily"))
+      mask |= SCHEDULE_DAYS_ALL;
+    else if (!strcasecmp(day, "weekday"))
+      mask |= SCHEDULE_DAYS_WEEKDAY;
+    else if (!strcasecmp(day, "weekend"))
+      mask |= SCHEDULE_DAYS_WEEKEND;
+    else {
+      int n;
+
+      for (n = 0; n < 7; n++)
+        if (!strcasecmp(day, _schedule_days[n]))
+          break;
+      if (n >= 7)
+        return 0;
+      mask |= 1 << n;
+    }
+  }
+  return mask;
+}
+
+/*
+   parse the given schedule text into the schedule
+
+   returns the number of entries, or -1 on error
+*/
+int ScheduleParse(const char *text, int len, CONFIG_SCHEDULE *schedule)
+{
+  char buffer[512];
+  char *line, *save_line;
+  unsigned int count = 0;
+
+  len = min(len, (int) sizeof(buffer) - 1);
+  memcpy(buffer, text, len);
+  buffer[len] = '\0';
+  memset(schedule, 0, sizeof(CONFIG_SCHEDULE));
+
+  for (line = strtok_r(buffer, ";\r\n", &save_line); line; line = strtok_r(NULL, ";\r\n", &save_line)) {
+    CONFIG_SCHEDULE_ENTRY *entry = &schedule->entries[count];
+    char *token, *save_token;
+    int hour, minute, mode;
+
+    if (!(token = strtok_r(line, " \t", &save_token)))
+      continue;
+    if (count >= SCHEDULE_ENTRIES) {
+      LogMsg("SCHEDULE: too many entries");
+      return -1;
+    }
+    if (strchr(token, ':'))
+      entry->days = SCHEDULE_DAYS_ALL;
+    else {
+      if (!(entry->days = schedule_parse_days(token)) || !(token = strtok_r(NULL, " \t", &save_token))) {
+        LogMsg("SCHEDULE: entry %d: bad days", count);
+        return -1;
+      }
+    }
+    if (sscanf(token, "%d:%d", &hour, &minute) != 2 || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+      LogMsg("SCHEDULE: entry %d: bad time", count);
+      return -1;
+    }
+    if (!(token = strtok_r(NULL, " \t", &save_token)) || (mode = AoxaParseMode(token, strlen(token))) == AOXA_MODE_LAST_PLUS_ONE) {
+      LogMsg("SCHEDULE: entry %d: bad mode", count);
+      return -1;
+    }
+    entry->hour = hour;
+    entry->minute = minute;
+    entry->mode = mode;
+    count++;
+  }
+  return count;
+}
+
+/*
+   check an entry as it was stored
+*/
+bool ScheduleEntryValid(const CONFIG_SCHEDULE_ENTRY *entry)
+{
+  if (!entry->days)
+    return true;
+  return !(entry->days & ~SCHEDULE_DAYS_ALL) && entry->hour <= 23 && entry->minute <= 59
+         && entry->mode >= AOXA_MODE_FIRST && entry->mode <= AOXA_MODE_LAST;
+}
+
+/*
+   format a schedule entry as a line of text
+*/
+const char *ScheduleEntryToString(const CONFIG_SCHEDULE_ENTRY *entry)
+{
+  static char buffer[48];
+  int len = 0;
+
+  if (!entry->days)
+    return NULL;
+  if (entry->days == SCHEDULE_DAYS_WEEKDAY)
+    len = sprintf(buffer, "weekday ");
+  else if (entry->days == SCHEDULE_DAYS_WEEKEND)
+    len = sprintf(buffer, "weekend ");
+  else if (entry->days != SCHEDULE_DAYS_ALL) {
+    for (int day = 0; day < 7; day++)
+      if (entry->days & (1 << day))
+        len += sprintf(&buffer[len], "%s,", _schedule_days[day]);
+    buffer[len - 1] = ' ';
+  }
+  sprintf(&buffer[len], "%02d:%02d %s\n", entry->hour, entry->minute, AoxaLookupMode(entry->mode));
+  return buffer;
+}
+
+/*
+   set and store a new schedule given as text
+
+   returns the number of entries, or -1 on error
+*/
+int ScheduleSet(const char *text, int len)
+{
+  CONFIG_SCHEDULE schedule;
+  int count;
+
+  if ((count = ScheduleParse(text, len, &schedule)) >= 0)
+    CONFIG_SET(CONFIG_SCHEDULE, schedule, &schedule);
+  return count;
+}
+
+/*
+   get the time of the next scheduled mode change, or 0 if nothing is scheduled
+*/
+time_t ScheduleNext(void)
+{
+  return _schedule_next;
+}
+
+#endif
+
+/**/
@@ -0,0 +1,97 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the time-of-day mode scheduler
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __SCHEDULE_H__
+#define __SCHEDULE_H__ 1
+
+#include <Time.h>
+#include "config.h"
+
+/*
+   number of schedule entries
+*/
+#define SCHEDULE_ENTRIES    (sizeof(((CONFIG_SCHEDULE *) 0)->entries) / sizeof(CONFIG_SCHEDULE_ENTRY))
+
+/*
+   the schedule is given as text, one entry per line or separated by ';'
+
+      [<days>] <HH:MM> <MODE>
+
+   days is a comma separated list of mon, tue, wed, thu, fri, sat, sun,
+   weekday or weekend -- without days, the entry fires every day
+
+   the times are in UTC, as the device clock is
+
+   example:
+
+      weekday 19:00 FIRE
+      sat,sun 10:00 FADE
+      23:30 OFF
+*/
+
+/*
+   setup the scheduler
+*/
+void ScheduleSetup(void);
+
+/*
+   cyclic update of the scheduler
+*/
+void ScheduleUpdate(void);
+
+/*
+   parse the given schedule text into the schedule
+
+   returns the number of entries, or -1 on error
+*/
+int ScheduleParse(const char *text, int len, CONFIG_SCHEDULE *schedule);
+
+/*
+   check an entry as it was stored, e.g. by an import -- unused entries are valid
+*/
+bool ScheduleEntryValid(const CONFIG_SCHEDULE_ENTRY *entry);
+
+/*
+   format a schedule entry as a line of text
+
+   returns NULL if the entry is unused -- the result is valid until the next call
+*/
+const char *ScheduleEntryToString(const CONFIG_SCHEDULE_ENTRY *entry);
+
+/*
+   set and store a new schedule given as text
+
+   returns the number of entries, or -1 on error
+*/
+int ScheduleSet(const char *text, int len);
+
+/*
+   get the time of the next scheduled mode change, or 0 if nothing is scheduled
+*/
+time_t ScheduleNext(void);
+
+#endif
+
+/**/
@@ -0,0 +1,847 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the HTTP connections
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "server.h"
+#include "util.h"
+
+#if FEATURE_HTTP
+
+/*
+   the states of a connection
+*/
+enum SERVER_STATE {
+  SERVER_STATE_FREE = 0,
+  SERVER_STATE_HEADERS,     // receiving the request line and the headers
+  SERVER_STATE_BODY,        // receiving the body
+  SERVER_STATE_STREAM,      // passing the body to the consumer
+};
+
+/*
+   a connection -- the request is received into its buffer and parsed in place
+*/
+typedef struct {
+  int state;
+  WiFiClient client;
+  uint32_t addr;
+  unsigned long start;
+  int len;
+  int header_len;
+  int content_length;
+  int received;             // bytes of a streamed body passed so far
+  int requests;             // requests served on the connection
+  SERVER_STREAM stream;
+  char buffer[SERVER_REQUEST_MAX + 1];
+} SERVER_CONNECTION;
+
+static WiFiServer _server(SERVER_PORT, SERVER_CONNECTIONS);
+static SERVER_CONNECTION _server_connections[SERVER_CONNECTIONS];
+
+/*
+   the routes
+*/
+static const SERVER_ROUTE *_server_routes = NULL;
+static int _server_route_count = 0;
+static SERVER_HANDLER _server_default_handler = NULL;
+
+/*
+   the responses are written one at a time, so they share the writer
+*/
+static WRITER _server_writer;
+
+static unsigned long _server_last_request = 0;
+
+/*
+   the token buckets of the clients -- the tokens are counted in
+   thousandths, so the refill needn't be rounded
+*/
+typedef struct {
+  uint32_t addr;
+  uint32_t tokens;
+  unsigned long last;
+} SERVER_BUCKET;
+
+static SERVER_BUCKET _server_buckets[SERVER_CLIENTS_TRACKED];
+
+/*
+   the time used by the handlers in the current second [us]
+*/
+static unsigned long _server_second_start = 0;
+static unsigned long _server_second_used = 0;
+
+/*
+   the connection to look at first in the next loop, so no connection
+   is always the one left over by the budget
+*/
+static int _server_next = 0;
+
+/*
+   the clients taken over by handlers -- they still hold their sockets
+*/
+static int _server_detached = 0;
+
+static SERVER_STATS _server_stats;
+
+/*
+   get the address of the client as a string
+*/
+static const char *server_remote(WiFiClient *client)
+{
+  uint32_t addr = client->remoteIP();
+
+  return AddressToString((byte *) &addr, sizeof(addr), true, '.');
+}
+
+/*
+   get the length of the body from the received headers
+
+   returns -1 if the length is not a number or too large for an int
+*/
+static int server_content_length(const char *headers)
+{
+  for (const char *line = strstr(headers, "\r\n"); line && line[2] != '\r'; line = strstr(line + 2, "\r\n")) {
+    const char *value = line + 2 + 15;
+    unsigned long len;
+    char *end;
+
+    if (strncasecmp(line + 2, "Content-Length:", 15))
+      continue;
+    while (*value == ' ' || *value == '\t')
+      value++;
+    if (*value < '0' || *value > '9')
+      return -1;
+    errno = 0;
+    len = strtoul(value, &end, 10);
+    while (*end == ' ' || *end == '\t')
+      end++;
+    if (errno || *end != '\r' || len > INT_MAX)
+      return -1;
+    return len;
+  }
+  return 0;
+}
+
+/*
+   take a token from the bucket of the client
+
+   returns false if the bucket is empty
+*/
+static bool server_admit(uint32_t addr)
+{
+  unsigned long now = millis();
+  SERVER_BUCKET *bucket = &_server_buckets[0];
+
+  /*
+     find the bucket of the client, or replace the one idle for the longest time
+  */
+  for (int n = 0; n < SERVER_CLIENTS_TRACKED; n++) {
+    if (_server_buckets[n].addr == addr) {
+      bucket = &_server_buckets[n];
+      break;
+    }
+    if (now - _server_buckets[n].last > now - bucket->last)
+      bucket = &_server_buckets[n];
+  }
+  if (bucket->addr != addr) {
+    bucket->addr = addr;
+    bucket->tokens = SERVER_BURST * 1000;
+  }
+  else {
+    /*
+       the time to fill the bucket is enough -- a longer one would overflow
+    */
+    unsigned long elapsed = min(now - bucket->last, (unsigned long) SERVER_BURST * 1000 / SERVER_RATE);
+
+    bucket->tokens = min((unsigned long) SERVER_BURST * 1000, bucket->tokens + elapsed * SERVER_RATE);
+  }
+  bucket->last = now;
+
+  if (bucket->tokens < 1000)
+    return false;
+  bucket->tokens -= 1000;
+  return true;
+}
+
+/*
+   count the connections of the client
+*/
+static int server_client_connections(uint32_t addr)
+{
+  int count = 0;
+
+  for (int n = 0; n < SERVER_CONNECTIONS; n++)
+    if (_server_connections[n].state != SERVER_STATE_FREE && _server_connections[n].addr == addr)
+      count++;
+  return count;
+}
+
+/*
+   count the sockets of the server -- the connections and the detached clients
+*/
+static int server_sockets(void)
+{
+  int count = _server_detached;
+
+  for (int n = 0; n < SERVER_CONNECTIONS; n++)
+    if (_server_connections[n].state != SERVER_STATE_FREE)
+      count++;
+  return count;
+}
+
+/*
+   decode the URL encoding in place
+*/
+static void server_url_decode(char *str)
+{
+  char *out = str;
+
+  for (; *str; str++) {
+    if (*str == '+')
+      *out++ = ' ';
+    else if (*str == '%' && isxdigit(str[1]) && isxdigit(str[2])) {
+      char hex[3] = { str[1], str[2], '\0' };
+
+      *out++ = strtol(hex, NULL, 16);
+      str += 2;
+    }
+    else
+      *out++ = *str;
+  }
+  *out = '\0';
+}
+
+/*
+   split the arguments of a query string or a form into the request
+*/
+static void server_parse_args(SERVER_REQUEST *request, char *args)
+{
+  while (args && *args) {
+    char *name = args;
+    char *value;
+
+    if ((args = strchr(args, '&')))
+      *args++ = '\0';
+    if ((value = strchr(name, '=')))
+      *value++ = '\0';
+    else
+      value = name + strlen(name);
+    if (!*name || request->args >= SERVER_ARGS_MAX)
+      continue;
+    server_url_decode(name);
+    server_url_decode(value);
+    request->arg_name[request->args] = name;
+    request->arg_value[request->args] = value;
+    request->args++;
+  }
+}
+
+/*
+   parse the received request of the connection
+
+   returns false if the request is malformed
+*/
+static bool server_parse(SERVER_CONNECTION *conn, SERVER_REQUEST *request)
+{
+  static const struct {
+    const char *name;
+    int method;
+  } methods[] = {
+    { "GET", SERVER_METHOD_GET },
+    { "HEAD", SERVER_METHOD_HEAD },
+    { "POST", SERVER_METHOD_POST },
+    { "PUT", SERVER_METHOD_PUT },
+  };
+  char *line = conn->buffer;
+  char *next;
+  char *method;
+  char *version;
+  char *query;
+  char *save;
+
+  memset(request, 0, sizeof(*request));
+  request->client = &conn->client;
+
+  /*
+     the request line
+  */
+  if (!(next = strstr(line, "\r\n")))
+    return false;
+  *next = '\0';
+  method = strtok_r(line, " ", &save);
+  request->path = strtok_r(NULL, " ", &save);
+  version = strtok_r(NULL, " ", &save);
+  if (!method || !request->path || !version)
+    return false;
+  request->keep_alive = !strcmp(version, "HTTP/1.1");
+  for (unsigned int n = 0; n < sizeof(methods) / sizeof(methods[0]); n++)
+    if (!strcmp(method, methods[n].name))
+      request->method = methods[n].method;
+  if ((query = strchr(request->path, '?')))
+    *query++ = '\0';
+
+  /*
+     the headers up to the empty line
+  */
+  for (line = next + 2; (next = strstr(line, "\r\n")) && next != line; line = next + 2) {
+    char *value = strchr(line, ':');
+
+    *next = '\0';
+    if (!value)
+      continue;
+    *value++ = '\0';
+    while (*value == ' ' || *value == '\t')
+      value++;
+    if (!strcasecmp(line, "Authorization"))
+      request->authorization = value;
+    else if (!strcasecmp(line, "If-None-Match"))
+      request->if_none_match = value;
+    else if (!strcasecmp(line, "Content-Type"))
+      request->content_type = value;
+    else if (!strcasecmp(line, "Connection"))
+      request->keep_alive = !strcasecmp(value, "keep-alive");
+  }
+
+  /*
+     the body -- unless it is streamed, then it isn't received yet
+  */
+  request->body_len = conn->content_length;
+  if (conn->state == SERVER_STATE_BODY) {
+    request->body = conn->buffer + conn->header_len;
+    request->body[request->body_len] = '\0';
+  }
+
+  server_url_decode(request->path);
+  server_parse_args(request, query);
+  if (request->body && request->content_type && !strncasecmp(request->content_type, "application/x-www-form-urlencoded", 33)) {
+    server_parse_args(request, request->body);
+    request->body = NULL;
+    request->body_len = 0;
+  }
+  return true;
+}
+
+/*
+   close the connection
+*/
+static void server_close(SERVER_CONNECTION *conn)
+{
+  conn->client.stop();
+  conn->state = SERVER_STATE_FREE;
+}
+
+/*
+   answer the client with an error and close the connection -- the
+   client is asked to come back later for 429 and 503
+*/
+static void server_reject(WiFiClient *client, int code)
+{
+  _server_writer.keep_alive = false;
+  WriterBegin(&_server_writer, client, code, "text/plain");
+  if (code == 429 || code == 503)
+    WriterHeader(&_server_writer, "Retry-After", "1");
+  WriterBody(&_server_writer, 0);
+  WriterEnd(&_server_writer);
+  client->stop();
+}
+
+/*
+   find the route of the given path -- the path ends with a blank, a
+   question mark or the terminator, so the request line can be checked
+   before it is parsed
+
+   returns NULL if no route matches
+*/
+static const SERVER_ROUTE *server_route(const char *path)
+{
+  int len = strcspn(path, " ?");
+
+  for (int n = 0; n < _server_route_count; n++) {
+    const SERVER_ROUTE *route = &_server_routes[n];
+    int route_len = strlen(route->path);
+
+    if ((route->flags & SERVER_ROUTE_PREFIX) ? len >= route_len && !strncmp(path, route->path, route_len) : len == route_len && !strncmp(path, route->path, len))
+      return route;
+  }
+  return NULL;
+}
+
+/*
+   check if the request of the connection goes to a streaming route
+*/
+static bool server_streamed(SERVER_CONNECTION *conn)
+{
+  const char *path = strchr(conn->buffer, ' ');
+  const SERVER_ROUTE *route;
+
+  return path && (route = server_route(path + 1)) && (route->flags & SERVER_ROUTE_STREAM);
+}
+
+/*
+   pass a piece of the streamed body to its consumer -- the connection is
+   closed when the body is complete or the consumer aborted
+*/
+static void server_stream(SERVER_CONNECTION *conn, const uint8_t *data, int len)
+{
+  _server_writer.keep_alive = false;
+  conn->received += len;
+  if (!conn->stream(&conn->client, &_server_writer, data, len)) {
+    server_close(conn);
+    return;
+  }
+  if (conn->received >= conn->content_length) {
+    conn->stream(&conn->client, &_server_writer, NULL, 0);
+    server_close(conn);
+  }
+}
+
+/*
+   receive the next piece of the streamed body -- never waits
+*/
+static void server_receive_stream(SERVER_CONNECTION *conn)
+{
+  int available = conn->client.available();
+  int n;
+
+  if (available > 0) {
+    n = conn->client.read((uint8_t *) conn->buffer, min(available, min(SERVER_REQUEST_MAX, conn->content_length - conn->received)));
+    if (n > 0) {
+      conn->start = millis();
+      server_stream(conn, (const uint8_t *) conn->buffer, n);
+    }
+    return;
+  }
+  if (!conn->client.connected() || millis() - conn->start > SERVER_STREAM_TIMEOUT) {
+    LogMsg("HTTP: stream from %s broke off after %d bytes", server_remote(&conn->client), conn->received);
+    conn->stream(&conn->client, &_server_writer, NULL, -1);
+    server_close(conn);
+  }
+}
+
+/*
+   keep the connection for the next request -- what the client sent
+   behind the request already is moved to the front of the buffer
+*/
+static void server_keep(SERVER_CONNECTION *conn)
+{
+  int used = conn->header_len + conn->content_length;
+
+  conn->len -= used;
+  memmove(conn->buffer, conn->buffer + used, conn->len + 1);
+  conn->state = SERVER_STATE_HEADERS;
+  conn->header_len = conn->content_length = 0;
+  conn->start = millis();
+  conn->requests++;
+}
+
+/*
+   pass the received request to its handler
+*/
+static void server_dispatch(SERVER_CONNECTION *conn)
+{
+  SERVER_REQUEST request;
+  const SERVER_ROUTE *route;
+  SERVER_HANDLER handler = _server_default_handler;
+  unsigned long start = micros();
+  char next;
+
+  _server_last_request = millis();
+  _server_stats.requests++;
+
+  /*
+     admission control
+  */
+  if (!server_admit(conn->addr)) {
+    _server_stats.rate_limited++;
+    server_reject(&conn->client, 429);
+    conn->state = SERVER_STATE_FREE;
+    return;
+  }
+  if (_server_last_request - _server_second_start >= 1000) {
+    _server_second_start = _server_last_request;
+    _server_second_used = 0;
+  }
+  if (_server_second_used >= SERVER_SECOND_BUDGET * 1000UL) {
+    _server_stats.busy++;
+    server_reject(&conn->client, 429);
+    conn->state = SERVER_STATE_FREE;
+    return;
+  }
+
+  /*
+     the request is parsed in place -- the terminator of the body overwrites
+     the first byte of a pipelined request, which is restored afterwards
+  */
+  next = (conn->state == SERVER_STATE_BODY) ? conn->buffer[conn->header_len + conn->content_length] : '\0';
+  if (!server_parse(conn, &request)) {
+    server_reject(&conn->client, 400);
+    conn->state = SERVER_STATE_FREE;
+    return;
+  }
+  if (conn->requests)
+    _server_stats.reused++;
+  _server_writer.keep_alive = request.keep_alive && request.method != SERVER_METHOD_HEAD &&
+                              conn->state == SERVER_STATE_BODY && conn->requests < SERVER_KEEPALIVE_MAX - 1;
+  DbgMsg("HTTP: request %s from %s", request.path, server_remote(&conn->client));
+
+  if ((route = server_route(request.path)))
+    handler = route->handler;
+  handler(&request, &_server_writer);
+  _server_second_used += micros() - start;
+  if (request.stream && conn->state == SERVER_STATE_STREAM) {
+    /*
+       the handler takes the body -- pass what was received with the headers
+    */
+    conn->stream = request.stream;
+    conn->received = 0;
+    conn->start = millis();
+    if (!conn->content_length) {
+      conn->stream(&conn->client, &_server_writer, NULL, 0);
+      server_close(conn);
+    }
+    else if (conn->len > conn->header_len)
+      server_stream(conn, (const uint8_t *) conn->buffer + conn->header_len, min(conn->len - conn->header_len, conn->content_length));
+  }
+  else if (request.detached) {
+    /*
+       the handler keeps its own copy of the client, so just let go of it
+    */
+    conn->client = WiFiClient();
+    conn->state = SERVER_STATE_FREE;
+    _server_detached++;
+  }
+  else if (_server_writer.keep_alive && !_server_writer.failed) {
+    conn->buffer[conn->header_len + conn->content_length] = next;
+    server_keep(conn);
+  }
+  else
+    server_close(conn);
+}
+
+/*
+   check if the request in the buffer is complete and dispatch it
+
+   returns false if the request is not yet complete
+*/
+static bool server_process(SERVER_CONNECTION *conn)
+{
+  if (conn->state == SERVER_STATE_HEADERS) {
+    char *end = strstr(conn->buffer, "\r\n\r\n");
+
+    if (!end)
+      return false;
+
+    /*
+       the headers are complete -- look for the length of the body
+    */
+    conn->header_len = end + 4 - conn->buffer;
+    conn->content_length = server_content_length(conn->buffer);
+    if (conn->content_length >= 0 && server_streamed(conn)) {
+      conn->state = SERVER_STATE_STREAM;
+      server_dispatch(conn);
+      return true;
+    }
+    if (conn->content_length < 0 || conn->content_length > SERVER_REQUEST_MAX - conn->header_len) {
+      server_reject(&conn->client, 413);
+      conn->state = SERVER_STATE_FREE;
+      return true;
+    }
+    conn->state = SERVER_STATE_BODY;
+  }
+  if (conn->len < conn->header_len + conn->content_length)
+    return false;
+  server_dispatch(conn);
+  return true;
+}
+
+/*
+   receive what is available on the connection -- never waits
+
+   a kept connection may hold the next request already, so it is
+   processed even if nothing was received
+*/
+static void server_receive(SERVER_CONNECTION *conn)
+{
+  int available = conn->client.available();
+  bool idle = !conn->len;
+
+  if (available > 0) {
+    int room = SERVER_REQUEST_MAX - conn->len;
+    int n;
+
+    if (room <= 0) {
+      server_reject(&conn->client, 413);
+      conn->state = SERVER_STATE_FREE;
+      return;
+    }
+    if ((n = conn->client.read((uint8_t *) conn->buffer + conn->len, min(available, room))) > 0) {
+      conn->len += n;
+      conn->buffer[conn->len] = '\0';
+
+      /*
+         on a kept connection, the time of the request starts with it
+      */
+      if (idle && conn->requests)
+        conn->start = millis();
+    }
+  }
+  else if (!conn->client.connected()) {
+    server_close(conn);
+    return;
+  }
+
+  if (conn->len && server_process(conn))
+    return;
+
+  if (!conn->len && conn->requests) {
+    /*
+       a kept connection without a new request is closed silently
+    */
+    if (millis() - conn->start > SERVER_IDLE_TIMEOUT)
+      server_close(conn);
+  }
+  else if (millis() - conn->start > SERVER_REQUEST_TIMEOUT) {
+    LogMsg("HTTP: request from %s timed out", server_remote(&conn->client));
+    _server_stats.timeouts++;
+    server_reject(&conn->client, 408);
+    conn->state = SERVER_STATE_FREE;
+  }
+}
+
+/*
+   find the kept connection which is idle for the longest time -- of the
+   given client, or of any client with addr 0
+
+   returns NULL if there is none
+*/
+static SERVER_CONNECTION *server_idle_connection(uint32_t addr)
+{
+  unsigned long now = millis();
+  SERVER_CONNECTION *idle = NULL;
+
+  for (int n = 0; n < SERVER_CONNECTIONS; n++) {
+    SERVER_CONNECTION *conn = &_server_connections[n];
+
+    if (conn->state != SERVER_STATE_HEADERS || !conn->requests || conn->len || (addr && conn->addr != addr))
+      continue;
+    if (!idle || now - conn->start > now - idle->start)
+      idle = conn;
+  }
+  return idle;
+}
+
+/*
+   take over new connections into free slots
+*/
+static void server_accept(void)
+{
+  for (int accepted = 0; accepted < SERVER_CONNECTIONS; accepted++) {
+    WiFiClient client = _server.available();
+    SERVER_CONNECTION *conn = NULL;
+    uint32_t addr;
+
+    if (!client)
+      return;
+    addr = client.remoteIP();
+
+    /*
+       a client with its share of the connections may only replace one of
+       its idle ones, others take a free one or the longest idle one
+    */
+    if (server_client_connections(addr) >= SERVER_CONNECTIONS_PER_CLIENT)
+      conn = server_idle_connection(addr);
+    else {
+      /*
+         a free slot is only taken while the detached clients leave a
+         socket for it
+      */
+      for (int n = 0; n < SERVER_CONNECTIONS && !conn && server_sockets() < SERVER_CONNECTIONS; n++)
+        if (_server_connections[n].state == SERVER_STATE_FREE)
+          conn = &_server_connections[n];
+      if (!conn)
+        conn = server_idle_connection(0);
+    }
+    if (!conn) {
+      /*
+         all slots are busy, or the client has its share -- don't keep it waiting
+      */
+      _server_stats.rejected++;
+      server_reject(&client, 503);
+      continue;
+    }
+    if (conn->state != SERVER_STATE_FREE)
+      server_close(conn);
+    conn->client = client;
+    conn->addr = addr;
+    conn->client.setNoDelay(true);
+    conn->client.setTimeout(SERVER_WRITE_TIMEOUT);
+    conn->state = SERVER_STATE_HEADERS;
+    conn->start = millis();
+    conn->len = conn->header_len = conn->content_length = conn->requests = 0;
+  }
+}
+
+/*
+   setup the server with the given routes
+*/
+void ServerSetup(const SERVER_ROUTE *routes, int count, SERVER_HANDLER default_handler)
+{
+  _server_routes = routes;
+  _server_route_count = count;
+  _server_default_handler = default_handler;
+  _server.begin();
+  _server.setNoDelay(true);
+  _server_last_request = millis();
+}
+
+/*
+   cyclic update of the server
+*/
+void ServerUpdate(void)
+{
+  unsigned long start = millis();
+  int first = _server_next;
+
+  server_accept();
+  for (int n = 0; n < SERVER_CONNECTIONS; n++) {
+    SERVER_CONNECTION *conn = &_server_connections[(first + n) % SERVER_CONNECTIONS];
+
+    if (conn->state == SERVER_STATE_FREE)
+      continue;
+    if (millis() - start >= SERVER_LOOP_BUDGET) {
+      /*
+         the budget of this loop is used up -- go on with this one next time
+      */
+      _server_stats.deferred++;
+      _server_next = (first + n) % SERVER_CONNECTIONS;
+      return;
+    }
+    if (conn->state == SERVER_STATE_STREAM)
+      server_receive_stream(conn);
+    else
+      server_receive(conn);
+  }
+  _server_next = (first + 1) % SERVER_CONNECTIONS;
+}
+
+/*
+   get the value of an argument of the request
+*/
+const char *ServerArg(const SERVER_REQUEST *request, const char *name)
+{
+  for (int n = 0; n < request->args; n++)
+    if (!strcmp(request->arg_name[n], name))
+      return request->arg_value[n];
+  return NULL;
+}
+
+/*
+   check the Basic Auth credentials of the request
+
+   the credentials are encoded and compared to the header, so the header
+   needn't be decoded
+*/
+bool ServerAuthenticate(const SERVER_REQUEST *request, const char *user, const char *password)
+{
+  static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char plain[128];
+  char encoded[(sizeof(plain) + 2) / 3 * 4 + 1];
+  int len, n, out = 0;
+
+  if (!request->authorization || strncasecmp(request->authorization, "Basic ", 6))
+    return false;
+  len = snprintf(plain, sizeof(plain), "%s:%s", user, password);
+  if (len >= (int) sizeof(plain))
+    return false;
+
+  for (n = 0; n < len; n += 3) {
+    uint32_t bits = (byte) plain[n] << 16 | (n + 1 < len ? (byte) plain[n + 1] << 8 : 0) | (n + 2 < len ? (byte) plain[n + 2] : 0);
+
+    encoded[out++] = base64[(bits >> 18) & 0x3f];
+    encoded[out++] = base64[(bits >> 12) & 0x3f];
+    encoded[out++] = n + 1 < len ? base64[(bits >> 6) & 0x3f] : '=';
+    encoded[out++] = n + 2 < len ? base64[bits & 0x3f] : '=';
+  }
+  encoded[out] = '\0';
+  return !strcmp(request->authorization + 6, encoded);
+}
+
+/*
+   answer the request with the request for credentials
+*/
+void ServerRequestAuthentication(SERVER_REQUEST *request, WRITER *writer)
+{
+  static const char text[] = "Authentication required";
+
+  WriterBegin(writer, request->client, 401, "text/plain");
+  WriterHeader(writer, "WWW-Authenticate", "Basic realm=\"" __TITLE__ "\"");
+  WriterBody(writer, sizeof(text) - 1);
+  WriterPrint(writer, text);
+  WriterEnd(writer);
+}
+
+/*
+   answer the request with the given status and a short text
+*/
+void ServerError(SERVER_REQUEST *request, WRITER *writer, int code, const char *text)
+{
+  WriterBegin(writer, request->client, code, "text/plain");
+  WriterBody(writer, strlen(text));
+  WriterPrint(writer, text);
+  WriterEnd(writer);
+}
+
+/*
+   get the counters of the server
+*/
+const SERVER_STATS *ServerStats(void)
+{
+  return &_server_stats;
+}
+
+/*
+   a detached client was closed by its handler
+*/
+void ServerRelease(void)
+{
+  if (_server_detached > 0)
+    _server_detached--;
+}
+
+/*
+   return the time in milli seconds of the last request
+*/
+unsigned long ServerLastRequest(void)
+{
+  return _server_last_request;
+}
+
+#endif
+
+/**/
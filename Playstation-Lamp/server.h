@@ -0,0 +1,233 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to handle the HTTP connections
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __SERVER_H__
+#define __SERVER_H__ 1
+
+#include <WiFi.h>
+#include "config.h"
+#include "writer.h"
+
+/*
+   the port to listen on
+*/
+#define SERVER_PORT             80
+
+/*
+   number of connections served at the same time -- the clients detached
+   by a handler, e.g. the subscribers of the event stream, count as well
+
+   the network stack has 10 sockets (CONFIG_LWIP_MAX_SOCKETS), they are
+   taken by the listener, these connections, MQTT, NTP, the DNS of the
+   access point and briefly by a rejected connection -- that leaves one
+   to spare
+*/
+#define SERVER_CONNECTIONS      4
+
+/*
+   max. size of a request including its headers and body -- the forms are
+   sent with GET, so the rules and the schedule have to fit in the URL
+*/
+#define SERVER_REQUEST_MAX      2048
+
+/*
+   max. number of arguments of a request
+*/
+#define SERVER_ARGS_MAX         24
+
+/*
+   a request has to be received completely within this time [ms]
+*/
+#define SERVER_REQUEST_TIMEOUT  5000
+
+/*
+   a connection is kept for further requests -- it is closed if the next
+   request doesn't start within this time [ms], or after this number of
+   requests
+*/
+#define SERVER_IDLE_TIMEOUT     5000
+#define SERVER_KEEPALIVE_MAX    32
+
+/*
+   a response has to be taken by the client within this time [s]
+*/
+#define SERVER_WRITE_TIMEOUT    2
+
+/*
+   admission control -- a client may send SERVER_RATE requests per second
+   on average with bursts of up to SERVER_BURST requests, and may hold
+   SERVER_CONNECTIONS_PER_CLIENT of the connections -- the buckets of the
+   last SERVER_CLIENTS_TRACKED clients are kept
+*/
+#define SERVER_RATE                     4
+#define SERVER_BURST                    12
+#define SERVER_CONNECTIONS_PER_CLIENT   2
+#define SERVER_CLIENTS_TRACKED          8
+
+/*
+   the time budget of the handlers [ms] -- once the budget of a loop is
+   used up, the other connections wait for the next loop, once the budget
+   of a second is used up, further requests are answered with 429
+*/
+#define SERVER_LOOP_BUDGET      20
+#define SERVER_SECOND_BUDGET    250
+
+/*
+   the counters of the server
+*/
+typedef struct _server_stats {
+  unsigned long requests;
+  unsigned long rate_limited;   // 429, the client exceeded its rate
+  unsigned long busy;           // 429, the budget of the second was used up
+  unsigned long rejected;       // 503, no free connection or too many of the client
+  unsigned long deferred;       // connections left for the next loop
+  unsigned long timeouts;       // 408, the request wasn't complete in time
+  unsigned long reused;         // requests on a kept connection
+} SERVER_STATS;
+
+/*
+   a streamed body has to go on within this time [ms]
+*/
+#define SERVER_STREAM_TIMEOUT   10000
+
+/*
+   the request methods
+*/
+enum SERVER_METHOD {
+  SERVER_METHOD_UNKNOWN = 0,
+  SERVER_METHOD_GET,
+  SERVER_METHOD_HEAD,
+  SERVER_METHOD_POST,
+  SERVER_METHOD_PUT,
+};
+
+/*
+   a parsed request -- all strings point into the receive buffer of the
+   connection and are valid while the handler runs
+*/
+typedef struct _server_request {
+  WiFiClient *client;
+  int method;
+  char *path;
+  int args;
+  char *arg_name[SERVER_ARGS_MAX];
+  char *arg_value[SERVER_ARGS_MAX];
+  const char *authorization;
+  const char *if_none_match;
+  const char *content_type;
+  char *body;
+  int body_len;
+  bool keep_alive;  // the client wants to keep the connection
+  bool detached;    // set by a handler which took over the client, see ServerRelease()
+  bool (*stream)(WiFiClient *client, WRITER *writer, const uint8_t *data, int len);
+} SERVER_REQUEST;
+
+/*
+   the consumer of a streamed body -- see SERVER_ROUTE_STREAM
+
+   it gets the body in pieces as they arrive, then it is called with data
+   NULL and len 0 to write the response -- with len -1 the client is gone
+   or timed out and no response is needed
+
+   it returns false to abort, after it has written a response
+*/
+typedef bool (*SERVER_STREAM)(WiFiClient *client, WRITER *writer, const uint8_t *data, int len);
+
+/*
+   the handler of a request -- it has to write the complete response
+*/
+typedef void (*SERVER_HANDLER)(SERVER_REQUEST *request, WRITER *writer);
+
+/*
+   a route -- the path has to match exactly, or with SERVER_ROUTE_PREFIX
+   it has to start with it
+
+   with SERVER_ROUTE_STREAM the body is not buffered and may be of any
+   size -- the handler is called as soon as the headers are received, with
+   body NULL and body_len the length of the body, and sets stream in the
+   request to take the body, or answers the request as usual to refuse it
+*/
+#define SERVER_ROUTE_PREFIX     0x01
+#define SERVER_ROUTE_STREAM     0x02
+
+typedef struct _server_route {
+  const char *path;
+  SERVER_HANDLER handler;
+  int flags;
+} SERVER_ROUTE;
+
+/*
+   setup the server with the given routes
+
+   requests which match no route are passed to the default handler
+*/
+void ServerSetup(const SERVER_ROUTE *routes, int count, SERVER_HANDLER default_handler);
+
+/*
+   cyclic update of the server -- it never waits for a client
+*/
+void ServerUpdate(void);
+
+/*
+   get the value of an argument of the request
+
+   returns NULL if the argument is not given
+*/
+const char *ServerArg(const SERVER_REQUEST *request, const char *name);
+
+/*
+   check the Basic Auth credentials of the request
+*/
+bool ServerAuthenticate(const SERVER_REQUEST *request, const char *user, const char *password);
+
+/*
+   answer the request with the request for credentials
+*/
+void ServerRequestAuthentication(SERVER_REQUEST *request, WRITER *writer);
+
+/*
+   answer the request with the given status and a short text
+*/
+void ServerError(SERVER_REQUEST *request, WRITER *writer, int code, const char *text);
+
+/*
+   get the counters of the server
+*/
+const SERVER_STATS *ServerStats(void);
+
+/*
+   a handler which detached a client has to call this once it closed the
+   client, so its socket is available for connections again
+*/
+void ServerRelease(void);
+
+/*
+   return the time in milli seconds of the last request
+*/
+unsigned long ServerLastRequest(void);
+
+#endif
+
+/**/
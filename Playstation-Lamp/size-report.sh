@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+#	this script builds the sketch with different feature selections
+#	and reports the flash and RAM usage of each build compared to the
+#	build with all features enabled
+#
+#	it needs arduino-cli with the ESP32 core installed
+#
+#	usage: size-report.sh [<fqbn>]
+#
+#	the features are the FEATURE_* switches in config.h
+#
+
+FQBN=${1:-esp32:esp32:d1_mini32}
+SKETCH=$( cd "$( dirname "$0" )" ; pwd )
+
+CONFIGS=(
+	"all:"
+	"no-http:-DFEATURE_HTTP=0 -DFEATURE_OTA=0"
+	"no-mqtt:-DFEATURE_MQTT=0"
+	"no-rules:-DFEATURE_RULES=0"
+	"no-schedule:-DFEATURE_SCHEDULE=0"
+	"no-ntp:-DFEATURE_NTP=0 -DFEATURE_SCHEDULE=0"
+	"no-cli:-DFEATURE_CLI=0"
+	"no-ota:-DFEATURE_OTA=0"
+	"minimal:-DFEATURE_MQTT=0 -DFEATURE_NTP=0 -DFEATURE_RULES=0 -DFEATURE_SCHEDULE=0 -DFEATURE_CLI=0 -DFEATURE_OTA=0"
+)
+
+# build the sketch with the given flags and print "<flash> <ram>"
+build()
+{
+	arduino-cli compile --fqbn "$FQBN" --build-property "compiler.cpp.extra_flags=$1" "$SKETCH" 2>&1 |
+		sed -n -e 's/^Sketch uses \([0-9]*\) bytes.*/\1/p' -e 's/^Global variables use \([0-9]*\) bytes.*/\1/p' |
+		tr '\n' ' '
+}
+
+printf "%-12s %10s %10s %10s %10s\n" "config" "flash" "saved" "ram" "saved"
+for CONFIG in "${CONFIGS[@]}"; do
+	NAME=${CONFIG%%:*}
+	FLAGS=${CONFIG#*:}
+	read FLASH RAM <<< "$( build "$FLAGS" )"
+	if [ -z "$RAM" ]; then
+		echo "$NAME: build failed" >&2
+		exit 1
+	fi
+	[ "$NAME" = "all" ] && FLASH_ALL=$FLASH && RAM_ALL=$RAM
+	printf "%-12s %10d %10d %10d %10d\n" "$NAME" $FLASH $(( FLASH_ALL - FLASH )) $RAM $(( RAM_ALL - RAM ))
+done
@@ -0,0 +1,264 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to push the state to the web clients with Server-Sent Events
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <lwip/sockets.h>
+#include "config.h"
+#include "sse.h"
+#include "http.h"
+#include "wifi.h"
+#if FEATURE_MQTT
+#include "mqtt.h"
+#endif
+#include "aoxa.h"
+#include "event.h"
+
+#if FEATURE_HTTP
+
+/*
+   a subscribed client
+*/
+typedef struct {
+  bool used;
+  bool frames;                  // the client wants the LED frames
+  bool state;                   // the client still needs the current state
+  WiFiClient client;
+  unsigned long last;           // time of the last message
+} SSE_CLIENT;
+
+static SSE_CLIENT _sse_clients[SSE_CLIENTS];
+static int _sse_count = 0;
+
+/*
+   the state changed since the last update -- set by the event handler,
+   so the producers never wait for the clients
+*/
+static bool _sse_state_changed = false;
+
+/*
+   the last frame sent
+*/
+static int _sse_frame[AOXA_LEDS_MAX];
+static int _sse_frame_leds = 0;
+static unsigned long _sse_frame_last = 0;
+
+/*
+   the message buffer shared by all clients
+*/
+static char _sse_message[32 + AOXA_LEDS_MAX * 6];
+
+/*
+   drop a client
+*/
+static void sse_drop(SSE_CLIENT *client)
+{
+  client->client.stop();
+  client->client = WiFiClient();
+  client->used = false;
+  ServerRelease();
+  _sse_count--;
+  DbgMsg("SSE: client dropped, %d left", _sse_count);
+}
+
+/*
+   send the message to the client without waiting
+
+   a client which has no room for the message skips it, a client which
+   took only a part of it is dropped, as its stream is broken
+
+   returns true if the message was sent
+*/
+static bool sse_send(SSE_CLIENT *client, const char *message, int len)
+{
+  int sent = send(client->client.fd(), message, len, MSG_DONTWAIT);
+
+  if (sent == len) {
+    client->last = millis();
+    return true;
+  }
+  if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    return false;
+  sse_drop(client);
+  return false;
+}
+
+/*
+   format the state message
+*/
+static int sse_state_message(void)
+{
+  return snprintf(_sse_message, sizeof(_sse_message),
+                  "event: state\ndata: {\"mode\":\"%s\",\"brightness\":%d,\"wifi\":%s,\"mqtt\":%s}\n\n",
+                  AoxaLookupMode(AoxaGetMode()), AoxaGetBrightness(),
+                  WifiConnected() ? "true" : "false",
+#if FEATURE_MQTT
+                  MqttConnected() ? "true" : "false"
+#else
+                  "null"
+#endif
+                 );
+}
+
+/*
+   format the frame message -- returns 0 if the frame didn't change
+*/
+static int sse_frame_message(void)
+{
+  int frame[AOXA_LEDS_MAX];
+  int leds = AoxaGetFrame(frame);
+  int len;
+
+  if (leds == _sse_frame_leds && !memcmp(frame, _sse_frame, leds * sizeof(frame[0])))
+    return 0;
+  memcpy(_sse_frame, frame, leds * sizeof(frame[0]));
+  _sse_frame_leds = leds;
+
+  len = snprintf(_sse_message, sizeof(_sse_message), "event: frame\ndata: [");
+  for (int led = 0; led < leds; led++)
+    len += snprintf(_sse_message + len, sizeof(_sse_message) - len, led ? ",%d" : "%d", frame[led]);
+  len += snprintf(_sse_message + len, sizeof(_sse_message) - len, "]\n\n");
+  return len;
+}
+
+/*
+   note the changes of the state
+*/
+static void sse_event_handler(const EVENT *event)
+{
+  _sse_state_changed = true;
+}
+
+/*
+   setup the push channel
+*/
+void SseSetup(void)
+{
+  EventSubscribe("sse",
+                 EVENT_MASK(EVENT_AOXA_MODE) | EVENT_MASK(EVENT_AOXA_BRIGHTNESS) | EVENT_MASK(EVENT_WIFI) | EVENT_MASK(EVENT_MQTT),
+                 sse_event_handler);
+}
+
+/*
+   cyclic update of the push channel
+*/
+void SseUpdate(void)
+{
+  unsigned long now = millis();
+  int len;
+
+  if (!_sse_count)
+    return;
+
+  /*
+     the state -- a client which couldn't take it gets it with the next update
+  */
+  if (_sse_state_changed) {
+    _sse_state_changed = false;
+    for (int n = 0; n < SSE_CLIENTS; n++)
+      _sse_clients[n].state = _sse_clients[n].used;
+  }
+  len = 0;
+  for (int n = 0; n < SSE_CLIENTS; n++) {
+    SSE_CLIENT *client = &_sse_clients[n];
+
+    if (!client->used || !client->state)
+      continue;
+    if (!len)
+      len = sse_state_message();
+    if (sse_send(client, _sse_message, len))
+      client->state = false;
+  }
+
+  /*
+     the frames -- at a bounded rate and only if they changed, a client
+     which couldn't take a frame just misses it
+  */
+  if (now - _sse_frame_last >= SSE_FRAME_INTERVAL) {
+    _sse_frame_last = now;
+    len = -1;
+    for (int n = 0; n < SSE_CLIENTS; n++) {
+      SSE_CLIENT *client = &_sse_clients[n];
+
+      if (!client->used || !client->frames)
+        continue;
+      if (len < 0)
+        len = sse_frame_message();
+      if (len)
+        sse_send(client, _sse_message, len);
+    }
+  }
+
+  /*
+     keep alive, and check for clients which left
+  */
+  for (int n = 0; n < SSE_CLIENTS; n++) {
+    SSE_CLIENT *client = &_sse_clients[n];
+
+    if (!client->used)
+      continue;
+    if (!client->client.connected())
+      sse_drop(client);
+    else if (now - client->last >= SSE_KEEPALIVE)
+      sse_send(client, ":\n\n", 3);
+  }
+}
+
+/*
+   subscribe the client of the request
+*/
+void SseSubscribe(SERVER_REQUEST *request, WRITER *w)
+{
+  SSE_CLIENT *client = NULL;
+
+  if (!HttpAuthorized(request, w, false))
+    return;
+  for (int n = 0; n < SSE_CLIENTS && !client; n++)
+    if (!_sse_clients[n].used)
+      client = &_sse_clients[n];
+  if (!client) {
+    ServerError(request, w, 503, "Too many subscribers");
+    return;
+  }
+
+  WriterBegin(w, request->client, 200, "text/event-stream");
+  WriterHeader(w, "Cache-Control", "no-store");
+  WriterBody(w, WRITER_NO_BODY);
+  WriterPrintf(w, "retry: %d\n\n", SSE_KEEPALIVE / 3);
+  if (!WriterEnd(w))
+    return;
+
+  client->used = true;
+  client->frames = ServerArg(request, "frames") != NULL;
+  client->state = true;
+  client->client = *request->client;
+  client->last = millis();
+  _sse_count++;
+  _sse_frame_leds = 0;
+  request->detached = true;
+  DbgMsg("SSE: client subscribed, %d now", _sse_count);
+}
+
+#endif
+
+/**/
@@ -0,0 +1,72 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to push the state to the web clients with Server-Sent Events
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __SSE_H__
+#define __SSE_H__ 1
+
+#include "config.h"
+#include "server.h"
+
+/*
+   the path of the event stream -- with the argument frames, the values
+   of the LEDs are streamed too
+*/
+#define SSE_PATH              "/api/events"
+
+/*
+   number of clients subscribed at the same time -- each of them holds
+   a socket and one of the SERVER_CONNECTIONS for as long as it is
+   subscribed, so some are left for the requests
+*/
+#define SSE_CLIENTS           2
+
+/*
+   min. interval of the LED frames [ms]
+*/
+#define SSE_FRAME_INTERVAL    100
+
+/*
+   interval of the keep alive comments, so dead clients are noticed [ms]
+*/
+#define SSE_KEEPALIVE         15000
+
+/*
+   setup the push channel
+*/
+void SseSetup(void);
+
+/*
+   cyclic update of the push channel -- sends what changed to the clients
+*/
+void SseUpdate(void);
+
+/*
+   the handler of SSE_PATH -- subscribes the client
+*/
+void SseSubscribe(SERVER_REQUEST *request, WRITER *w);
+
+#endif
+
+/**/
@@ -120,6 +120,27 @@ void dump(String title, const void *addr, const int len)
   }
 }
 
+/*
+   compute the CRC32 (IEEE 802.3) of the given data
+
+   the CRC of consecutive blocks can be computed by passing the previous CRC
+*/
+uint32_t Crc32(const void *data, int len, uint32_t crc)
+{
+  static const uint32_t table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+  };
+
+  crc = ~crc;
+  for (int n = 0; n < len; n++) {
+    crc ^= ((const byte *) data)[n];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+  }
+  return ~crc;
+}
+
 /*
  * get a time in ascii
  */
@@ -155,4 +176,50 @@ void LogMsg(const char *fmt, ...)
     Serial.println(msg);
     Serial.flush();
   }
+}
+
+/*
+   the recorded boot phases
+*/
+static struct {
+  const char *name;
+  unsigned long time;
+} _boot_phases[BOOT_PHASES_MAX];
+static int _boot_phase_count = 0;
+
+/*
+   record the end of a boot phase with its time since reset
+*/
+void BootPhase(const char *name)
+{
+  if (_boot_phase_count >= BOOT_PHASES_MAX)
+    return;
+  _boot_phases[_boot_phase_count].name = name;
+  _boot_phases[_boot_phase_count].time = millis();
+  LogMsg("BOOT: phase %s done after %lums", name, _boot_phases[_boot_phase_count].time);
+  _boot_phase_count++;
+}
+
+/*
+   get the number of recorded boot phases
+*/
+int BootPhases(void)
+{
+  return _boot_phase_count;
+}
+
+/*
+   get the name of the recorded boot phase
+*/
+const char *BootPhaseName(int phase)
+{
+  return (phase >= 0 && phase < _boot_phase_count) ? _boot_phases[phase].name : NULL;
+}
+
+/*
+   get the time in milli seconds since reset of the recorded boot phase
+*/
+unsigned long BootPhaseTime(int phase)
+{
+  return (phase >= 0 && phase < _boot_phase_count) ? _boot_phases[phase].time : 0;
 }/**/
@@ -40,6 +40,11 @@
 
 #define MAC_ADDR_LEN  6
 
+/*
+   max. number of recorded boot phases
+*/
+#define BOOT_PHASES_MAX   12
+
 /*
    convert an IP address to a C string
 */
@@ -71,6 +76,11 @@ const byte *StringToAddress(const char *str, int addrlen, bool dec);
 */
 void dump(String title, const void *addr, const int len);
 
+/*
+   compute the CRC32 (IEEE 802.3) of the given data
+*/
+uint32_t Crc32(const void *data, int len, uint32_t crc = 0);
+
 /*
  * get a time in ascii
  */
@@ -81,6 +91,26 @@ const char *TimeToString(time_t t);
 */
 void LogMsg(const char *fmt, ...);
 
+/*
+   record the end of a boot phase with its time since reset
+*/
+void BootPhase(const char *name);
+
+/*
+   get the number of recorded boot phases
+*/
+int BootPhases(void);
+
+/*
+   get the name of the recorded boot phase
+*/
+const char *BootPhaseName(int phase);
+
+/*
+   get the time in milli seconds since reset of the recorded boot phase
+*/
+unsigned long BootPhaseTime(int phase);
+
 #endif
 
 /**/
@@ -26,60 +26,217 @@
 #include "config.h"
 #include "wifi.h"
 #include "state.h"
+#include "event.h"
 #include "util.h"
 
 WiFiClient _wifiClient;
 static DNSServer *_dns_server = NULL;
 static char _AP_SSID[64] = "";
+static bool _wifi_connected = false;
+static bool _wifi_ever_connected = false;   // with the current credentials
+static bool _wifi_booted = false;
+static unsigned long _wifi_connect_start = 0;
+static unsigned long _wifi_ap_opened = 0;     // time the access point was opened, 0 if it isn't
+static CONFIG_WIFI _config_wifi;
 
 /*
-   setup wifi
+   the cached result of the background scan
 */
-bool WifiSetup(void)
+static WIFI_NETWORK _wifi_networks[WIFI_SCAN_MAX];
+static int _wifi_network_count = 0;
+static bool _wifi_scanning = false;
+static unsigned long _wifi_scan_time = 0;     // time of the last scan, 0 if there is none
+static unsigned long _wifi_scan_demand = 0;   // time the list was asked for last
+
+/*
+   open an AccessPoint for the configuration mode -- its DNS is started by
+   wifi_start_dns() once it is up
+*/
+static void wifi_open_ap(void)
 {
-  LogMsg("WIFI: my MAC address is %s", WifiGetMacAddr().c_str());
+  uint8_t mac[MAC_ADDR_LEN];
+  strcpy(_AP_SSID, (String(WIFI_AP_SSID_PREFIX) + String(AddressToString((byte *) WiFi.macAddress(mac) + sizeof(mac) - WIFI_AP_SSID_USE_LAST_MAC_DIGITS, WIFI_AP_SSID_USE_LAST_MAC_DIGITS, false,':'))).c_str());
+
+  LogMsg("WIFI: opening access point with SSID %s ...", _AP_SSID);
+  WiFi.disconnect();
+  WiFi.mode(WIFI_AP_STA);   // the station is needed to scan for networks
+  WiFi.softAP(_AP_SSID);
+  _wifi_ap_opened = millis() | 1;
+}
+
+/*
+   start the DNS of the access point
+*/
+static void wifi_start_dns(void)
+{
+  LogMsg("WIFI: local IP address %s", IPAddressToString(WiFi.softAPIP()).c_str());
+
+  /*
+     configure the DNS so that every requests will go to our device
+  */
+  _dns_server = new DNSServer();
+  _dns_server->setErrorReplyCode(DNSReplyCode::NoError);
+  _dns_server->start(DNS_PORT, "*", WiFi.softAPIP());
+  LogMsg("WIFI: DNS setup to redirect all traffic to %s", IPAddressToString(WiFi.softAPIP()).c_str());
+}
+
+/*
+   take over the result of the finished scan -- the networks are sorted by
+   their RSSI and only the strongest of each SSID is kept
+*/
+static void wifi_scan_done(int count)
+{
+  _wifi_network_count = 0;
+  for (int n = 0; n < count; n++) {
+    WIFI_NETWORK network;
+    int pos;
+
+    strncpy(network.ssid, WiFi.SSID(n).c_str(), sizeof(network.ssid) - 1);
+    network.ssid[sizeof(network.ssid) - 1] = '\0';
+    network.rssi = WiFi.RSSI(n);
+    network.channel = WiFi.channel(n);
+    network.secure = WiFi.encryptionType(n) != WIFI_AUTH_OPEN;
+    if (!network.ssid[0])
+      continue;
 
-  if (StateCheck(STATE_CONFIGURING)) {
     /*
-       open an AccessPoint
+       skip it if the SSID is known with a stronger signal, or drop the weaker one
+    */
+    for (pos = 0; pos < _wifi_network_count && strcmp(_wifi_networks[pos].ssid, network.ssid); pos++)
+      ;
+    if (pos < _wifi_network_count) {
+      if (_wifi_networks[pos].rssi >= network.rssi)
+        continue;
+      memmove(&_wifi_networks[pos], &_wifi_networks[pos + 1], (_wifi_network_count - pos - 1) * sizeof(WIFI_NETWORK));
+      _wifi_network_count--;
+    }
+
+    /*
+       insert it sorted -- the weakest falls off the end of a full list
     */
-    uint8_t mac[MAC_ADDR_LEN];
-    strcpy(_AP_SSID, (String(WIFI_AP_SSID_PREFIX) + String(AddressToString((byte *) WiFi.macAddress(mac) + sizeof(mac) - WIFI_AP_SSID_USE_LAST_MAC_DIGITS, WIFI_AP_SSID_USE_LAST_MAC_DIGITS, false,':'))).c_str());
+    for (pos = _wifi_network_count; pos > 0 && _wifi_networks[pos - 1].rssi < network.rssi; pos--)
+      ;
+    if (pos >= WIFI_SCAN_MAX)
+      continue;
+    if (_wifi_network_count < WIFI_SCAN_MAX)
+      _wifi_network_count++;
+    memmove(&_wifi_networks[pos + 1], &_wifi_networks[pos], (_wifi_network_count - pos - 1) * sizeof(WIFI_NETWORK));
+    _wifi_networks[pos] = network;
+  }
+  WiFi.scanDelete();
+  _wifi_scan_time = millis() | 1;
+  DbgMsg("WIFI: scan found %d networks, %d kept", count, _wifi_network_count);
+}
+
+/*
+   run the background scan -- it is started when the list is old and was
+   asked for, and it is never waited for
+*/
+static void wifi_scan_update(bool idle)
+{
+  unsigned long now = millis();
+  int count;
+
+  if (_wifi_scanning) {
+    if ((count = WiFi.scanComplete()) == WIFI_SCAN_RUNNING)
+      return;
+    _wifi_scanning = false;
+    if (count >= 0)
+      wifi_scan_done(count);
+    else {
+      LogMsg("WIFI: scan failed");
+      WiFi.scanDelete();
+      _wifi_scan_time = now | 1;
+    }
+    return;
+  }
 
-    LogMsg("WIFI: opening access point with SSID %s ...", _AP_SSID);
-    WiFi.softAP(_AP_SSID);
-    delay(1000);
+  /*
+     the first scan is done as soon as the radio is idle, further ones
+     only on demand
+  */
+  if (!idle)
+    return;
+  if (_wifi_scan_time && (now - _wifi_scan_time < WIFI_SCAN_INTERVAL * 1000UL || now - _wifi_scan_demand > WIFI_SCAN_DEMAND * 1000UL))
+    return;
+  if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+    _wifi_scan_time = now | 1;
+    return;
+  }
+  _wifi_scanning = true;
+}
 
-    LogMsg("WIFI: local IP address %s", IPAddressToString(WiFi.softAPIP()).c_str());
+/*
+   this handler is called whenever the config was changed
+*/
+static void wifi_event_handler(const EVENT *event)
+{
+  CONFIG_WIFI config_wifi;
 
+  if (!CONFIG_COVERS(event->arg, event->arg2, WIFI, wifi))
+    return;
+
+  CONFIG_GET(WIFI, wifi, &config_wifi);
+  if (!memcmp(&config_wifi, &_config_wifi, sizeof(CONFIG_WIFI)))
+    return;
+
+  /*
+     the credentials changed -- re-associate in the background, and fall
+     back to the access point if they don't work
+  */
+  _config_wifi = config_wifi;
+  LogMsg("WIFI: settings changed -- connecting to %s in the background ...", _config_wifi.ssid);
+  WiFi.disconnect();
+  WiFi.begin(_config_wifi.ssid, _config_wifi.psk);
+  _wifi_ever_connected = false;
+  _wifi_connect_start = millis();
+}
+
+/*
+   setup wifi
+
+   in normal operation mode, this will only start to connect -- the
+   connection is established in the background and checked in WifiUpdate()
+*/
+bool WifiSetup(void)
+{
+  LogMsg("WIFI: my MAC address is %s", WifiGetMacAddr());
+
+  if (StateCheck(STATE_CONFIGURING)) {
     /*
-       configure the DNS so that every requests will go to our device
+       open an AccessPoint
     */
-    _dns_server = new DNSServer();
-    _dns_server->setErrorReplyCode(DNSReplyCode::NoError);
-    _dns_server->start(DNS_PORT, "*", WiFi.softAPIP());
-    LogMsg("WIFI: DNS setup to redirect all traffic to %s", IPAddressToString(WiFi.softAPIP()).c_str());
+    wifi_open_ap();
     return false;
   }
-  else {
-    /*
-      connect to the configured Wifi network
-    */
-    DbgMsg("WIFI: SSID=%s  PSK=%s", _config.wifi.ssid, _config.wifi.psk);
 
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(_config.wifi.ssid, _config.wifi.psk);
+  /*
+    connect to the configured Wifi network
+  */
+  CONFIG_GET(WIFI, wifi, &_config_wifi);
+  EventSubscribe("wifi", EVENT_MASK(EVENT_CONFIG), wifi_event_handler);
+  DbgMsg("WIFI: SSID=%s  PSK=%s", _config_wifi.ssid, _config_wifi.psk);
 
-    LogMsg("WIFI: waiting to connect to %s ...", _config.wifi.ssid);
-  }
-  return WifiUpdate();
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(_config_wifi.ssid, _config_wifi.psk);
+  _wifi_connect_start = millis();
+
+  LogMsg("WIFI: connecting to %s in the background ...", _config_wifi.ssid);
+  return true;
 }
 
 /*
    do Wifi updates
+
+   returns true if we are connected to the configured WiFi
 */
 bool WifiUpdate(void)
 {
+  /*
+     scan only while the station doesn't try to connect
+  */
+  wifi_scan_update(StateCheck(STATE_CONFIGURING) ? _dns_server != NULL : _wifi_connected);
+
   if (StateCheck(STATE_CONFIGURING)) {
     /*
        we are in configuration mode
@@ -88,42 +245,60 @@ bool WifiUpdate(void)
     */
     if (_dns_server)
       _dns_server->processNextRequest();
+    else if (_wifi_ap_opened && millis() - _wifi_ap_opened >= WIFI_AP_SETTLE)
+      wifi_start_dns();
+    return false;
   }
-  else {
-    /*
-       normal operation mode
-    */
-    if (WiFi.status() != WL_CONNECTED) {
-      /*
-         wait to connect
-      */
-      int retries = WIFI_CONNECT_RETRIES;
-
-      DbgMsg("WIFI: status is not connected ... waiting for connection");
-      while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
-        if (--retries <= 0) {
-          LogMsg("WIFI: giving up after %d retries", WIFI_CONNECT_RETRIES);
-          return false;
-        }
-      }
 
+  /*
+     normal operation mode
+  */
+  if (WiFi.status() != WL_CONNECTED) {
+    if (_wifi_connected) {
+      LogMsg("WIFI: connection lost");
+      _wifi_connected = false;
+      EventPublish(EVENT_WIFI, false);
+    }
+    if (!_wifi_ever_connected && millis() - _wifi_connect_start > WIFI_CONNECT_TIMEOUT * 1000UL) {
       /*
-         up an running
+         we never got a connection -- enter configuration mode
       */
-      IPAddress ip = WiFi.localIP();
-      LogMsg("WIFI: connected to %s with local IP address %s", _config.wifi.ssid, IPAddressToString(ip).c_str());
+      LogMsg("WIFI: giving up after %d seconds -- entering configuration mode", WIFI_CONNECT_TIMEOUT);
+      StateChange(STATE_CONFIGURING);
+      wifi_open_ap();
     }
+    return false;
+  }
+
+  if (!_wifi_connected) {
+    /*
+       up an running
+    */
+    IPAddress ip = WiFi.localIP();
+    LogMsg("WIFI: connected to %s with local IP address %s", _config_wifi.ssid, IPAddressToString(ip).c_str());
+
+    if (!_wifi_booted)
+      BootPhase("wifi");
+    _wifi_connected = _wifi_ever_connected = _wifi_booted = true;
+    EventPublish(EVENT_WIFI, true);
   }
   return true;
 }
 
+/*
+   check if we are connected to the configured WiFi
+*/
+bool WifiConnected(void)
+{
+  return _wifi_connected;
+}
+
 /*
    return the SSID
 */
-String WifiGetSSID(void)
+const char *WifiGetSSID(void)
 {
-  return StateCheck(STATE_CONFIGURING) ? _AP_SSID : WiFi.SSID();
+  return StateCheck(STATE_CONFIGURING) ? _AP_SSID : _config_wifi.ssid;
 }
 
 /*
@@ -138,21 +313,40 @@ int WifiGetRSSI(void)
 /*
    return the SSID
 */
-String WifiGetIpAddr(void)
+const char *WifiGetIpAddr(void)
 {
-  return IPAddressToString(StateCheck(STATE_CONFIGURING) ? WiFi.softAPIP() : WiFi.localIP());
+  uint32_t addr = StateCheck(STATE_CONFIGURING) ? WiFi.softAPIP() : WiFi.localIP();
+
+  return AddressToString((byte *) &addr, sizeof(addr), true, '.');
 }
 
 /*
    return the Wifi MAC address
 */
-String WifiGetMacAddr(void)
+const char *WifiGetMacAddr(void)
 {
   uint8_t mac[MAC_ADDR_LEN];
 
-  return String(AddressToString((byte *) WiFi.macAddress(mac), sizeof(mac), false,':'));
+  return AddressToString((byte *) WiFi.macAddress(mac), sizeof(mac), false,':');
+}
+
+/*
+   get the networks found by the last scan
+*/
+int WifiGetNetworks(const WIFI_NETWORK **networks)
+{
+  _wifi_scan_demand = millis();
+  *networks = _wifi_networks;
+  return _wifi_network_count;
 }
 
+/*
+   get the age of the list of networks
+*/
+int WifiGetNetworksAge(void)
+{
+  return _wifi_scan_time ? (millis() - _wifi_scan_time) / 1000 : -1;
+}
 
 WiFiClient *WifiGetClient(void)
 {
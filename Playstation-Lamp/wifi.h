@@ -46,17 +46,39 @@ extern WiFiClient _wifiClient;
 #define WIFI_AP_SSID_USE_LAST_MAC_DIGITS   3
 
 /*
-   number of retries to connect to the configured Wifi
+   time in seconds to wait for the first connection to the configured Wifi
 
-   when retrie count is reached, we will give up -- the device will enter the configuration mode
+   when the timeout is reached, we will give up -- the device will enter the configuration mode
 */
-#define WIFI_CONNECT_RETRIES          20
+#define WIFI_CONNECT_TIMEOUT          20
+
+/*
+   time in milli seconds the access point takes to come up before its DNS
+   is started
+*/
+#define WIFI_AP_SETTLE                1000
 
 /*
    port for the DNS
 */
 #define DNS_PORT  53
 
+/*
+   the networks found by the background scan -- the list is refreshed
+   at most every WIFI_SCAN_INTERVAL seconds, and only as long as it was
+   asked for within the last WIFI_SCAN_DEMAND seconds
+*/
+#define WIFI_SCAN_MAX                 16
+#define WIFI_SCAN_INTERVAL            60
+#define WIFI_SCAN_DEMAND              (5 * 60)
+
+typedef struct _wifi_network {
+  char ssid[33];
+  int8_t rssi;
+  uint8_t channel;
+  bool secure;
+} WIFI_NETWORK;
+
 /*
    compute the WiFi signal strength in percent out of the RSSI
 */
@@ -69,13 +91,20 @@ bool WifiSetup(void);
 
 /*
    do Wifi updates
+
+   returns true if we are connected to the configured WiFi
 */
 bool WifiUpdate(void);
 
+/*
+   check if we are connected to the configured WiFi
+*/
+bool WifiConnected(void);
+
 /*
    return the SSID
 */
-String WifiGetSSID(void);
+const char *WifiGetSSID(void);
 
 /*
    return the SSID
@@ -85,12 +114,25 @@ int WifiGetRSSI(void);
 /*
    return the own IP address
 */
-String WifiGetIpAddr(void);
+const char *WifiGetIpAddr(void);
 
 /*
    return the Wifi MAC address
 */
-String WifiGetMacAddr(void);
+const char *WifiGetMacAddr(void);
+
+/*
+   get the networks found by the last scan, sorted by their RSSI -- this
+   never waits for a scan, but asks for a fresh list
+
+   returns the number of networks
+*/
+int WifiGetNetworks(const WIFI_NETWORK **networks);
+
+/*
+   get the age of the list of networks in seconds, or -1 if there is none yet
+*/
+int WifiGetNetworksAge(void);
 
 /*
    get the WiFi client object for Wifi users
@@ -0,0 +1,283 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to stream HTTP responses
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "writer.h"
+
+/*
+   the data in the buffer starts behind the room for the chunk size
+*/
+#define WRITER_DATA(writer)   ((writer)->buffer + WRITER_CHUNK_HEADER)
+
+/*
+   get the reason phrase of a status code
+*/
+static const char *writer_reason(int code)
+{
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 408: return "Request Timeout";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 503: return "Service Unavailable";
+  }
+  return "Internal Server Error";
+}
+
+/*
+   copy written data into the capture buffer
+*/
+static void writer_capture(WRITER *writer, const void *data, int len)
+{
+  if (!writer->capture || writer->capture_len > writer->capture_size)
+    return;
+  if (writer->capture_len + len > writer->capture_size) {
+    writer->capture_len = writer->capture_size + 1;
+    return;
+  }
+  memcpy(writer->capture + writer->capture_len, data, len);
+  writer->capture_len += len;
+}
+
+/*
+   write the buffer to the client -- as a chunk, if the body is chunked
+*/
+static void writer_flush(WRITER *writer)
+{
+  char *data = WRITER_DATA(writer);
+  int len = writer->len;
+
+  writer->len = 0;
+  if (!len || writer->failed)
+    return;
+
+  if (writer->chunked) {
+    /*
+       put the chunk size in front of the data and the CRLF behind it,
+       so the chunk goes out with one write
+    */
+    char size[WRITER_CHUNK_HEADER + 1];
+    int size_len = snprintf(size, sizeof(size), "%x\r\n", len);
+
+    memcpy(data + len, "\r\n", WRITER_CHUNK_TRAILER);
+    data -= size_len;
+    memcpy(data, size, size_len);
+    len += size_len + WRITER_CHUNK_TRAILER;
+  }
+
+  if ((int) writer->client->write((const uint8_t *) data, len) != len)
+    writer->failed = true;
+  writer->bytes += len;
+}
+
+/*
+   start a response with the given status and content type to the client
+*/
+void WriterBegin(WRITER *writer, WiFiClient *client, int code, const char *content_type)
+{
+  writer->client = client;
+  writer->chunked = false;
+  writer->failed = false;
+  writer->len = 0;
+  writer->bytes = 0;
+  writer->capture = NULL;
+
+  WriterPrintf(writer, "HTTP/1.1 %d %s\r\n", code, writer_reason(code));
+  WriterHeader(writer, "Connection", writer->keep_alive ? "keep-alive" : "close");
+  if (content_type)
+    WriterHeader(writer, "Content-Type", content_type);
+}
+
+/*
+   add a header to the response
+*/
+void WriterHeader(WRITER *writer, const char *name, const char *value)
+{
+  WriterPrintf(writer, "%s: %s\r\n", name, value);
+}
+
+/*
+   end the headers
+*/
+void WriterBody(WRITER *writer, int len)
+{
+  if (len == WRITER_NO_BODY)
+    WriterPrint(writer, "\r\n");
+  else if (len == WRITER_CHUNKED)
+    WriterPrint(writer, "Transfer-Encoding: chunked\r\n\r\n");
+  else
+    WriterPrintf(writer, "Content-Length: %d\r\n\r\n", len);
+
+  /*
+     the headers must not be a part of the first chunk
+  */
+  if (len == WRITER_CHUNKED) {
+    writer_flush(writer);
+    writer->chunked = true;
+  }
+}
+
+/*
+   write data to the response
+*/
+void WriterWrite(WRITER *writer, const void *data, int len)
+{
+  const char *p = (const char *) data;
+
+  writer_capture(writer, data, len);
+
+  /*
+     a large block of a body with a known length goes out as it is,
+     instead of being copied through the buffer
+  */
+  if (len >= WRITER_BUFFER_SIZE && !writer->chunked) {
+    writer_flush(writer);
+    if (!writer->failed && (int) writer->client->write((const uint8_t *) p, len) != len)
+      writer->failed = true;
+    writer->bytes += len;
+    return;
+  }
+
+  while (len > 0) {
+    int room = WRITER_BUFFER_SIZE - writer->len;
+    int n = min(room, len);
+
+    memcpy(WRITER_DATA(writer) + writer->len, p, n);
+    writer->len += n;
+    p += n;
+    len -= n;
+    if (writer->len >= WRITER_BUFFER_SIZE)
+      writer_flush(writer);
+  }
+}
+
+/*
+   write a string to the response
+*/
+void WriterPrint(WRITER *writer, const char *str)
+{
+  WriterWrite(writer, str, strlen(str));
+}
+
+/*
+   write a formatted string to the response
+
+   the result is formatted right into the buffer -- if it doesn't fit,
+   the buffer is flushed and it is formatted again, a result larger
+   than the whole buffer is truncated
+*/
+void WriterPrintf(WRITER *writer, const char *fmt, ...)
+{
+  va_list args;
+  int room = WRITER_BUFFER_SIZE - writer->len;
+  int len;
+
+  /*
+     the NUL terminator may use the room for the chunk trailer
+  */
+  va_start(args, fmt);
+  len = vsnprintf(WRITER_DATA(writer) + writer->len, room + 1, fmt, args);
+  va_end(args);
+
+  if (len > room) {
+    writer_flush(writer);
+    va_start(args, fmt);
+    len = vsnprintf(WRITER_DATA(writer), WRITER_BUFFER_SIZE + 1, fmt, args);
+    va_end(args);
+    len = min(len, WRITER_BUFFER_SIZE);
+  }
+  if (len > 0) {
+    writer_capture(writer, WRITER_DATA(writer) + writer->len, len);
+    writer->len += len;
+  }
+  if (writer->len >= WRITER_BUFFER_SIZE)
+    writer_flush(writer);
+}
+
+/*
+   write a string with the HTML special characters escaped
+*/
+void WriterHtml(WRITER *writer, const char *str)
+{
+  const char *start = str;
+
+  for (; *str; str++) {
+    const char *entity;
+
+    switch (*str) {
+      case '&': entity = "&amp;"; break;
+      case '<': entity = "&lt;"; break;
+      case '>': entity = "&gt;"; break;
+      case '\'': entity = "&#39;"; break;
+      case '"': entity = "&quot;"; break;
+      default: continue;
+    }
+    WriterWrite(writer, start, str - start);
+    WriterPrint(writer, entity);
+    start = str + 1;
+  }
+  WriterWrite(writer, start, str - start);
+}
+
+/*
+   copy what is written from now on into the given buffer as well
+*/
+int WriterCapture(WRITER *writer, char *buffer, int size)
+{
+  int len = writer->capture_len;
+
+  if (writer->capture && len > writer->capture_size)
+    len = -1;
+  writer->capture = buffer;
+  writer->capture_size = size;
+  writer->capture_len = 0;
+  return len;
+}
+
+/*
+   finish the response
+*/
+bool WriterEnd(WRITER *writer)
+{
+  writer->capture = NULL;
+  writer_flush(writer);
+  if (writer->chunked) {
+    /*
+       the last chunk has a size of zero
+    */
+    writer->chunked = false;
+    WriterPrint(writer, "0\r\n\r\n");
+    writer_flush(writer);
+  }
+  return !writer->failed;
+}/**/
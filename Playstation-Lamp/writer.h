@@ -0,0 +1,118 @@
+/*
+  Playstation-Lamp
+
+  (c) 2020 Christian.Lorenz@gromeck.de
+
+  module to stream HTTP responses
+
+
+  This file is part of Playstation-Lamp.
+
+  Playstation-Lamp is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Playstation-Lamp is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Playstation-Lamp.  If not, see <https://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __WRITER_H__
+#define __WRITER_H__ 1
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+/*
+   size of the working buffer -- the body is sent in chunks of this size
+*/
+#define WRITER_BUFFER_SIZE    512
+
+/*
+   room for the chunk size in front of the data and the CRLF behind it
+*/
+#define WRITER_CHUNK_HEADER   6
+#define WRITER_CHUNK_TRAILER  2
+
+/*
+   special lengths of the body for WriterBody()
+*/
+#define WRITER_CHUNKED        -1    // the length is unknown, the body is chunked
+#define WRITER_NO_BODY        -2    // there is no body, e.g. for 304
+
+/*
+   the writer context
+
+   the response is collected in the buffer and written to the client
+   whenever the buffer is full, so the client sees few large writes --
+   nothing is allocated from the heap
+*/
+typedef struct _writer {
+  WiFiClient *client;
+  bool keep_alive;      // the connection is kept after the response, set by the server
+  bool chunked;         // the body is sent with chunked transfer encoding
+  bool failed;          // the client didn't take the data, the rest is dropped
+  int len;
+  unsigned long bytes;  // bytes sent so far
+  char *capture;        // the body is copied here too, see WriterCapture()
+  int capture_size;
+  int capture_len;      // beyond capture_size if the body didn't fit
+  char buffer[WRITER_CHUNK_HEADER + WRITER_BUFFER_SIZE + WRITER_CHUNK_TRAILER];
+} WRITER;
+
+/*
+   start a response with the given status and content type to the client
+
+   further headers can be added with WriterHeader() until WriterBody() is called --
+   the Connection header follows keep_alive, which is left as it is
+*/
+void WriterBegin(WRITER *writer, WiFiClient *client, int code, const char *content_type);
+
+/*
+   add a header to the response
+*/
+void WriterHeader(WRITER *writer, const char *name, const char *value);
+
+/*
+   end the headers -- the body has the given length, or see WRITER_CHUNKED
+   and WRITER_NO_BODY
+*/
+void WriterBody(WRITER *writer, int len);
+
+/*
+   write data, a string or a formatted string to the response
+*/
+void WriterWrite(WRITER *writer, const void *data, int len);
+void WriterPrint(WRITER *writer, const char *str);
+void WriterPrintf(WRITER *writer, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+/*
+   write a string with the HTML special characters escaped
+*/
+void WriterHtml(WRITER *writer, const char *str);
+
+/*
+   copy what is written from now on into the given buffer as well, e.g.
+   to cache it -- a NULL buffer stops copying
+
+   returns the number of bytes copied since the start, or -1 if they
+   didn't fit into the buffer
+*/
+int WriterCapture(WRITER *writer, char *buffer, int size);
+
+/*
+   finish the response
+
+   returns false if the client didn't take the whole response
+*/
+bool WriterEnd(WRITER *writer);
+
+#endif
+
+/**/